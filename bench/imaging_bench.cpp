@@ -0,0 +1,245 @@
+// Timings for the CPU imaging kernels on a synthetic CT-sized volume.
+// Build with -DDICOM_VIEWER_BUILD_BENCHMARKS=ON (Release) and run
+// `imaging_bench [slices]`; defaults to 512 x 512 x 600 int16.
+
+#include "imaging/PixelFormat.h"
+#include "imaging/RoiStatistics.h"
+#include "imaging/SlabProjector.h"
+#include "imaging/WindowLevelLut.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+template<typename F>
+double medianMs(F&& run, int iterations = 5)
+{
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        run();
+        samples.push_back(timer.nsecsElapsed() / 1e6);
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+vtkSmartPointer<vtkImageData> syntheticVolume(int columns, int rows, int slices)
+{
+    auto volume = vtkSmartPointer<vtkImageData>::New();
+    volume->SetDimensions(columns, rows, slices);
+    volume->AllocateScalars(VTK_SHORT, 1);
+
+    // Air outside a water cylinder with a few bright "vessels"
+    short* data = static_cast<short*>(volume->GetScalarPointer());
+    const int cx = columns / 2;
+    const int cy = rows / 2;
+    const int radius = std::min(columns, rows) * 2 / 5;
+    for (int z = 0; z < slices; ++z) {
+        for (int y = 0; y < rows; ++y) {
+            for (int x = 0; x < columns; ++x) {
+                const int dx = x - cx;
+                const int dy = y - cy;
+                short value = dx * dx + dy * dy < radius * radius ? 40 : -1000;
+                if ((x + 3 * z) % 97 == 0 || (y + 5 * z) % 131 == 0) value = 400;
+                *data++ = static_cast<short>(value + (x ^ y ^ z) % 16);
+            }
+        }
+    }
+    return volume;
+}
+
+void benchSlab(vtkImageData* volume, QThreadPool* pool)
+{
+    static const char* modeNames[] = {"MIP", "MinIP", "Mean"};
+    static const char* axisNames[] = {"sagittal", "coronal", "axial"};
+
+    int dims[3];
+    volume->GetDimensions(dims);
+
+    std::printf("\nThick slab (%d x %d x %d, %d threads)\n", dims[0], dims[1], dims[2], pool->maxThreadCount());
+    std::printf("%-6s %-9s %9s %10s\n", "mode", "axis", "thickness", "ms");
+
+    for (int axis = 2; axis >= 0; --axis) {
+        for (int mode = 0; mode < 3; ++mode) {
+            for (int thickness : {1, 10, 50, dims[axis]}) {
+                imaging::SlabParams params;
+                params.mode = static_cast<imaging::ProjectionMode>(mode);
+                params.axis = static_cast<imaging::SlabAxis>(axis);
+                params.position = dims[axis] / 2;
+                params.thickness = thickness;
+
+                vtkSmartPointer<vtkImageData> output;
+                const double ms = medianMs([&] {
+                    output = imaging::projectSlab(volume, params, pool, output);
+                });
+                std::printf("%-6s %-9s %9d %10.2f\n", modeNames[mode], axisNames[axis], thickness, ms);
+            }
+        }
+    }
+}
+
+void benchWindowLevel(QThreadPool* pool)
+{
+    // 4k x 4k 16-bit, mammography sized
+    const int size = 4096;
+    auto image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(size, size, 1);
+    image->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+    unsigned short* data = static_cast<unsigned short*>(image->GetScalarPointer());
+    for (int i = 0; i < size * size; ++i) {
+        data[i] = static_cast<unsigned short>((i * 2654435761u) >> 20);
+    }
+
+    auto display = vtkSmartPointer<vtkImageData>::New();
+    display->SetDimensions(size, size, 1);
+    display->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    unsigned char* out = static_cast<unsigned char*>(display->GetScalarPointer());
+
+    std::printf("\nWindow/level (%d x %d uint16, one update = new W/L)\n", size, size);
+
+    double window = 2000.0;
+    const double direct = medianMs([&] {
+        window += 1.0;
+        const imaging::WindowLevelClamps<unsigned short> clamps(window, 2048.0);
+        for (int i = 0; i < size * size; ++i) {
+            out[i] = clamps.map(data[i]);
+        }
+    });
+    std::printf("%-32s %10.2f ms\n", "per-pixel (1 thread)", direct);
+
+    const int full[4] = {0, size - 1, 0, size - 1};
+    const int quarter[4] = {size / 4, 3 * size / 4 - 1, size / 4, 3 * size / 4 - 1};
+    for (const int* region : {full, quarter}) {
+        imaging::WindowLevelLut lut;
+        const double ms = medianMs([&] {
+            window += 1.0;
+            imaging::VoiSettings voi;
+            voi.window = window;
+            voi.level = 2048.0;
+            lut.update(voi, VTK_UNSIGNED_SHORT);
+            lut.mapRegion(image, 0, region, display, pool);
+        });
+        std::printf("%-32s %10.2f ms\n", region == full ? "LUT, full frame" : "LUT, visible quarter", ms);
+    }
+}
+
+void benchRoi(vtkImageData* volume, QThreadPool* pool)
+{
+    int dims[3];
+    volume->GetDimensions(dims);
+    std::printf("\nROI statistics (%d x %d slice)\n", dims[0], dims[1]);
+
+    // Table build: a fresh slice each run
+    imaging::RoiStatistics roi(volume, 1.0, 0.0, 0.7, 0.7, pool);
+    int slice = 0;
+    const double build = medianMs([&] {
+        roi.rectangle(slice++ % dims[2], 0, 0, 0, 0);
+    });
+    std::printf("%-32s %10.3f ms\n", "tables (lazy, per slice)", build);
+
+    const int iterations = 1000;
+    int shift = 0;
+    const double rectangle = medianMs([&] {
+        for (int i = 0; i < iterations; ++i, ++shift) {
+            roi.rectangle(0, 100 + shift % 50, 100, 400 + shift % 50, 400);
+        }
+    }) / iterations;
+    std::printf("%-32s %10.3f ms\n", "rectangle 300 x 300", rectangle);
+
+    const double ellipse = medianMs([&] {
+        for (int i = 0; i < iterations; ++i, ++shift) {
+            roi.ellipse(0, QRectF(100 + shift % 50, 100, 300, 300));
+        }
+    }) / iterations;
+    std::printf("%-32s %10.3f ms\n", "ellipse 300 x 300", ellipse);
+}
+
+void benchUnpack()
+{
+    struct Case {
+        const char* name;
+        imaging::PixelFormat format;
+        bool rescale;
+    };
+
+    auto mono = [](int allocated, int stored, bool isSigned, bool bigEndian) {
+        imaging::PixelFormat format;
+        format.bitsAllocated = allocated;
+        format.bitsStored = stored;
+        format.highBit = stored - 1;
+        format.isSigned = isSigned;
+        format.bigEndian = bigEndian;
+        return format;
+    };
+    auto color = [](imaging::Photometric photometric, int planar) {
+        imaging::PixelFormat format;
+        format.bitsAllocated = 8;
+        format.bitsStored = 8;
+        format.highBit = 7;
+        format.samplesPerPixel = 3;
+        format.planarConfiguration = planar;
+        format.photometric = photometric;
+        return format;
+    };
+
+    const Case cases[] = {
+        {"MONO 8", mono(8, 8, false, false), false},
+        {"MONO 12u", mono(16, 12, false, false), false},
+        {"MONO 12u + rescale (CT)", mono(16, 12, false, false), true},
+        {"MONO 16s", mono(16, 16, true, false), false},
+        {"MONO 16s big endian", mono(16, 16, true, true), false},
+        {"RGB interleaved", color(imaging::Photometric::Rgb, 0), false},
+        {"RGB planar", color(imaging::Photometric::Rgb, 1), false},
+        {"YBR_FULL", color(imaging::Photometric::YbrFull, 0), false},
+    };
+
+    // 2k x 2k frame (CR/DX sized), decoded per call on one thread like the pipeline does
+    const int size = 2048;
+    std::vector<unsigned char> source(static_cast<std::size_t>(size) * size * 3 * 2);
+    for (std::size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<unsigned char>((i * 2654435761u) >> 24);
+    }
+    std::vector<unsigned char> dest(static_cast<std::size_t>(size) * size * 3 * 2);
+
+    std::printf("\nFused unpack (%d x %d frame, 1 thread)\n", size, size);
+    std::printf("%-26s %10s %10s\n", "format", "ms", "MB/s");
+    for (const Case& c : cases) {
+        const std::size_t bytes = static_cast<std::size_t>(size) * size * c.format.samplesPerPixel
+                                  * (c.format.bitsAllocated / 8);
+        imaging::UnpackResult result;
+        const double ms = medianMs([&] {
+            imaging::unpackPixels(c.format, source.data(), size, size, c.rescale, -1024, dest.data(), result);
+        });
+        std::printf("%-26s %10.2f %10.0f\n", c.name, ms, bytes / (ms * 1000.0));
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const int slices = argc > 1 ? std::max(1, std::atoi(argv[1])) : 600;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+
+    vtkSmartPointer<vtkImageData> volume = syntheticVolume(512, 512, slices);
+    benchSlab(volume, &pool);
+    benchWindowLevel(&pool);
+    benchRoi(volume, &pool);
+    benchUnpack();
+
+    return 0;
+}
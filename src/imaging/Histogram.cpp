@@ -0,0 +1,128 @@
+#include "Histogram.h"
+#include "ParallelFor.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <vtkImageData.h>
+#include <vtkSetGet.h>
+
+#include <algorithm>
+
+namespace imaging {
+
+namespace {
+
+template<typename T>
+void accumulate(const T* data, int slices, std::size_t sliceValues, int components,
+                double minValue, double binScale, QThreadPool* pool, QVector<quint32>& bins)
+{
+    QMutex mutex;
+    const int lastBin = static_cast<int>(bins.size()) - 1;
+
+    parallelFor(pool, 0, slices, 1, [&](int first, int last) {
+        QVector<quint32> local(bins.size(), 0);
+        for (int z = first; z < last; ++z) {
+            const T* slice = data + static_cast<std::size_t>(z) * sliceValues * components;
+            for (std::size_t i = 0; i < sliceValues; ++i) {
+                const int bin = static_cast<int>((slice[i * components] - minValue) * binScale);
+                ++local[std::min(std::max(bin, 0), lastBin)];
+            }
+        }
+
+        QMutexLocker locker(&mutex);
+        for (int b = 0; b <= lastBin; ++b) {
+            bins[b] += local[b];
+        }
+    });
+}
+
+} // namespace
+
+models::Histogram computeHistogram(vtkImageData* image, QThreadPool* pool, int binCount)
+{
+    models::Histogram histogram;
+    if (!image || binCount <= 0 || image->GetNumberOfPoints() == 0) return histogram;
+
+    double range[2];
+    image->GetScalarRange(range);
+    histogram.minValue = range[0];
+    histogram.maxValue = range[1];
+    histogram.bins.fill(0, binCount);
+
+    int dims[3];
+    image->GetDimensions(dims);
+    const std::size_t sliceValues = static_cast<std::size_t>(dims[0]) * dims[1];
+    const double span = range[1] - range[0];
+    const double binScale = span > 0.0 ? binCount / span : 0.0;
+
+    switch (image->GetScalarType()) {
+        vtkTemplateMacro(accumulate(static_cast<const VTK_TT*>(image->GetScalarPointer()), dims[2],
+                                    sliceValues, image->GetNumberOfScalarComponents(),
+                                    range[0], binScale, pool, histogram.bins));
+    default:
+        histogram.bins.clear();
+        break;
+    }
+
+    return histogram;
+}
+
+bool mergeValueCounts(const QVector<const models::ValueCounts*>& parts, models::ValueCounts& total)
+{
+    if (parts.isEmpty()) return false;
+
+    int first = parts.first()->firstValue;
+    int last = first;
+    for (const models::ValueCounts* part : parts) {
+        if (part->isEmpty()) return false;
+        first = std::min(first, part->firstValue);
+        last = std::max(last, part->firstValue + static_cast<int>(part->counts.size()));
+    }
+
+    models::ValueCounts merged;
+    merged.firstValue = first;
+    merged.counts.fill(0, last - first);
+    quint32* out = merged.counts.data();
+    for (const models::ValueCounts* part : parts) {
+        const quint32* counts = part->counts.constData();
+        quint32* dst = out + (part->firstValue - first);
+        const int size = static_cast<int>(part->counts.size());
+        for (int i = 0; i < size; ++i) {
+            dst[i] += counts[i];
+        }
+    }
+
+    total = merged;
+    return true;
+}
+
+models::Histogram binValueCounts(const models::ValueCounts& counts, int binCount)
+{
+    models::Histogram histogram;
+    if (binCount <= 0) return histogram;
+
+    // The measured range ends at the first and last value actually present
+    int lo = 0;
+    int hi = static_cast<int>(counts.counts.size()) - 1;
+    while (lo <= hi && counts.counts[lo] == 0) ++lo;
+    while (hi >= lo && counts.counts[hi] == 0) --hi;
+    if (lo > hi) return histogram;
+
+    histogram.minValue = counts.firstValue + lo;
+    histogram.maxValue = counts.firstValue + hi;
+    histogram.bins.fill(0, binCount);
+
+    // Same arithmetic as accumulate() above
+    const double span = histogram.maxValue - histogram.minValue;
+    const double binScale = span > 0.0 ? binCount / span : 0.0;
+    const int lastBin = binCount - 1;
+    for (int i = lo; i <= hi; ++i) {
+        const double value = counts.firstValue + i;
+        const int bin = static_cast<int>((value - histogram.minValue) * binScale);
+        histogram.bins[std::min(std::max(bin, 0), lastBin)] += counts.counts[i];
+    }
+    return histogram;
+}
+
+} // namespace imaging
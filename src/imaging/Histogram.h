@@ -0,0 +1,24 @@
+#ifndef IMAGING_HISTOGRAM_H
+#define IMAGING_HISTOGRAM_H
+
+#include "models/Histogram.h"
+
+class QThreadPool;
+class vtkImageData;
+
+namespace imaging {
+
+// Histogram of the first scalar component, computed per slice in parallel.
+models::Histogram computeHistogram(vtkImageData* image, QThreadPool* pool, int binCount = 4096);
+
+// Adds up per-frame value counts (from the unpack pass) over the union of
+// their ranges. Returns false, leaving `total` untouched, if any is empty.
+bool mergeValueCounts(const QVector<const models::ValueCounts*>& parts, models::ValueCounts& total);
+
+// Bins exact value counts the way computeHistogram() bins the pixels they
+// came from, so both give the same histogram for the same data.
+models::Histogram binValueCounts(const models::ValueCounts& counts, int binCount = 4096);
+
+} // namespace imaging
+
+#endif // IMAGING_HISTOGRAM_H
@@ -0,0 +1,82 @@
+#include "ParallelFor.h"
+
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace imaging {
+
+namespace {
+
+struct ParallelState {
+    int begin = 0;
+    int end = 0;
+    int grain = 1;
+    int chunkCount = 0;
+    const std::function<void(int, int)>* body = nullptr;
+
+    std::atomic<int> nextChunk{0};
+    std::atomic<int> finishedChunks{0};
+    std::mutex mutex;
+    std::condition_variable done;
+
+    // Returns false once every chunk has been claimed
+    bool runNextChunk()
+    {
+        const int chunk = nextChunk++;
+        if (chunk >= chunkCount) return false;
+
+        const int chunkBegin = begin + chunk * grain;
+        (*body)(chunkBegin, std::min(end, chunkBegin + grain));
+
+        if (++finishedChunks == chunkCount) {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+void parallelFor(QThreadPool* pool, int begin, int end, int grain,
+                 const std::function<void(int, int)>& body)
+{
+    if (end <= begin) return;
+
+    grain = std::max(1, grain);
+    const int chunkCount = (end - begin + grain - 1) / grain;
+    if (!pool || chunkCount == 1) {
+        for (int b = begin; b < end; b += grain) {
+            body(b, std::min(end, b + grain));
+        }
+        return;
+    }
+
+    auto state = std::make_shared<ParallelState>();
+    state->begin = begin;
+    state->end = end;
+    state->grain = grain;
+    state->chunkCount = chunkCount;
+    state->body = &body;
+
+    // Helpers that start late find no chunk left and return without
+    // touching `body`, which is only guaranteed alive until we return.
+    const int helpers = std::min(pool->maxThreadCount(), chunkCount - 1);
+    for (int i = 0; i < helpers; ++i) {
+        pool->start([state]() {
+            while (state->runNextChunk()) {}
+        });
+    }
+
+    while (state->runNextChunk()) {}
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&]() { return state->finishedChunks.load() == state->chunkCount; });
+}
+
+} // namespace imaging
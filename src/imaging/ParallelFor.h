@@ -0,0 +1,19 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <functional>
+
+class QThreadPool;
+
+namespace imaging {
+
+// Splits [begin, end) into chunks of `grain` items and runs body(chunkBegin,
+// chunkEnd) on the pool. The calling thread works through chunks as well
+// and only waits for chunks other threads already started, so it is safe
+// to call from inside a pool worker (no deadlock when the pool is full).
+void parallelFor(QThreadPool* pool, int begin, int end, int grain,
+                 const std::function<void(int, int)>& body);
+
+} // namespace imaging
+
+#endif // PARALLELFOR_H
@@ -0,0 +1,254 @@
+#include "PixelFormat.h"
+
+#include <vtkType.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace imaging {
+
+namespace {
+
+// Loop invariants of one frame, resolved before the kernel runs
+struct KernelParams {
+    const void* source;
+    void* dest;
+    int rows;
+    int columns;
+    int shift;          // HighBit + 1 - BitsStored
+    qint32 mask;        // (1 << BitsStored) - 1
+    qint32 signBit;     // 1 << (BitsStored - 1), or 0 for unsigned
+    qint32 storedMin;
+    qint32 intercept;
+    quint32* counts;    // one per stored value, from storedMin
+    qint32 minValue;
+    qint32 maxValue;
+};
+
+using Kernel = void (*)(KernelParams&);
+
+// --- Monochrome: unpack, mask, sign-extend, rescale, flip, count ---
+
+template<bool Wide, bool Signed, bool Swap, bool Rescale>
+void unpackMono(KernelParams& p)
+{
+    using In = typename std::conditional<Wide, quint16, quint8>::type;
+    using Stored = typename std::conditional<Signed, typename std::make_signed<In>::type, In>::type;
+    using Out = typename std::conditional<Rescale, qint16, Stored>::type;
+
+    const int shift = p.shift;
+    const qint32 mask = p.mask;
+    const qint32 signBit = Signed ? p.signBit : 0;
+    const qint32 storedMin = p.storedMin;
+    const qint32 offset = Rescale ? p.intercept : 0;
+    quint32* const counts = p.counts;
+    qint32 minValue = std::numeric_limits<qint32>::max();
+    qint32 maxValue = std::numeric_limits<qint32>::min();
+
+    for (int y = 0; y < p.rows; ++y) {
+        const In* __restrict src = static_cast<const In*>(p.source)
+                                   + static_cast<std::size_t>(p.rows - 1 - y) * p.columns;
+        Out* __restrict dst = static_cast<Out*>(p.dest) + static_cast<std::size_t>(y) * p.columns;
+
+        for (int x = 0; x < p.columns; ++x) {
+            quint32 raw = src[x];
+            if constexpr (Swap) raw = ((raw & 0xffu) << 8) | (raw >> 8);
+            // Sign extension without a branch: (v ^ s) - s
+            const qint32 stored = ((static_cast<qint32>(raw >> shift) & mask) ^ signBit) - signBit;
+            ++counts[stored - storedMin];
+            const qint32 value = stored + offset;
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+            dst[x] = static_cast<Out>(value);
+        }
+    }
+
+    p.minValue = minValue;
+    p.maxValue = maxValue;
+}
+
+// --- 8-bit color: interleave planes, YBR_FULL -> RGB, flip ---
+
+inline quint8 clampByte(qint32 value)
+{
+    return static_cast<quint8>(std::min(std::max(value, 0), 255));
+}
+
+template<bool Planar, bool Ybr>
+void unpackColor(KernelParams& p)
+{
+    const std::size_t planeSize = static_cast<std::size_t>(p.rows) * p.columns;
+    const quint8* source = static_cast<const quint8*>(p.source);
+
+    for (int y = 0; y < p.rows; ++y) {
+        const std::size_t srcRow = static_cast<std::size_t>(p.rows - 1 - y) * p.columns;
+        quint8* __restrict dst = static_cast<quint8*>(p.dest) + static_cast<std::size_t>(y) * p.columns * 3;
+
+        for (int x = 0; x < p.columns; ++x) {
+            const std::size_t i = srcRow + x;
+            const qint32 a = Planar ? source[i] : source[i * 3];
+            const qint32 b = Planar ? source[planeSize + i] : source[i * 3 + 1];
+            const qint32 c = Planar ? source[2 * planeSize + i] : source[i * 3 + 2];
+
+            if constexpr (Ybr) {
+                // PS3.3 C.7.6.3.1.2, 16.16 fixed point
+                const qint32 cb = b - 128;
+                const qint32 cr = c - 128;
+                dst[x * 3] = clampByte(a + ((91881 * cr + 32768) >> 16));
+                dst[x * 3 + 1] = clampByte(a - ((22554 * cb + 46802 * cr + 32768) >> 16));
+                dst[x * 3 + 2] = clampByte(a + ((116130 * cb + 32768) >> 16));
+            } else {
+                dst[x * 3] = static_cast<quint8>(a);
+                dst[x * 3 + 1] = static_cast<quint8>(b);
+                dst[x * 3 + 2] = static_cast<quint8>(c);
+            }
+        }
+    }
+
+    p.minValue = 0;
+    p.maxValue = 255;
+}
+
+// --- Dispatch tables, generated at compile time from the format bits ---
+
+enum MonoBits { MonoWide = 1, MonoSigned = 2, MonoSwap = 4, MonoRescale = 8, MonoCount = 16 };
+enum ColorBits { ColorPlanar = 1, ColorYbr = 2, ColorCount = 4 };
+
+template<std::size_t Index>
+constexpr Kernel monoKernel()
+{
+    return &unpackMono<(Index & MonoWide) != 0, (Index & MonoSigned) != 0,
+                       (Index & MonoSwap) != 0, (Index & MonoRescale) != 0>;
+}
+
+template<std::size_t Index>
+constexpr Kernel colorKernel()
+{
+    return &unpackColor<(Index & ColorPlanar) != 0, (Index & ColorYbr) != 0>;
+}
+
+template<std::size_t... Index>
+constexpr std::array<Kernel, sizeof...(Index)> makeMonoTable(std::index_sequence<Index...>)
+{
+    return {{monoKernel<Index>()...}};
+}
+
+template<std::size_t... Index>
+constexpr std::array<Kernel, sizeof...(Index)> makeColorTable(std::index_sequence<Index...>)
+{
+    return {{colorKernel<Index>()...}};
+}
+
+constexpr auto MonoKernels = makeMonoTable(std::make_index_sequence<MonoCount>());
+constexpr auto ColorKernels = makeColorTable(std::make_index_sequence<ColorCount>());
+
+} // namespace
+
+Photometric PixelFormat::photometricFromString(const QString& value)
+{
+    const QString name = value.trimmed().toUpper();
+    if (name == QLatin1String("MONOCHROME1")) return Photometric::Monochrome1;
+    if (name == QLatin1String("MONOCHROME2")) return Photometric::Monochrome2;
+    if (name == QLatin1String("RGB")) return Photometric::Rgb;
+    if (name == QLatin1String("YBR_FULL")) return Photometric::YbrFull;
+    return Photometric::Other;
+}
+
+bool PixelFormat::isMonochrome() const
+{
+    return samplesPerPixel == 1
+        && (photometric == Photometric::Monochrome1 || photometric == Photometric::Monochrome2);
+}
+
+bool PixelFormat::isSupported() const
+{
+    if (isMonochrome()) {
+        return (bitsAllocated == 8 || bitsAllocated == 16)
+            && bitsStored >= 1 && bitsStored <= bitsAllocated
+            && highBit >= bitsStored - 1 && highBit < bitsAllocated;
+    }
+
+    // Palette color, YBR_FULL_422 and friends go through DicomImage
+    return samplesPerPixel == 3 && bitsAllocated == 8 && bitsStored == 8
+        && (photometric == Photometric::Rgb || photometric == Photometric::YbrFull);
+}
+
+int PixelFormat::storedMin() const
+{
+    return isSigned ? -(1 << (bitsStored - 1)) : 0;
+}
+
+int PixelFormat::storedMax() const
+{
+    return isSigned ? (1 << (bitsStored - 1)) - 1 : (1 << bitsStored) - 1;
+}
+
+bool canRescaleToInt16(const PixelFormat& format, double slope, double intercept)
+{
+    if (!format.isMonochrome() || slope != 1.0 || intercept == 0.0 || std::floor(intercept) != intercept) {
+        return false;
+    }
+    return format.storedMin() + intercept >= std::numeric_limits<qint16>::min()
+        && format.storedMax() + intercept <= std::numeric_limits<qint16>::max();
+}
+
+int outputScalarType(const PixelFormat& format, bool rescale)
+{
+    if (!format.isMonochrome()) return VTK_UNSIGNED_CHAR;
+    if (rescale) return VTK_SHORT;
+    if (format.bitsAllocated == 16) return format.isSigned ? VTK_SHORT : VTK_UNSIGNED_SHORT;
+    return format.isSigned ? VTK_SIGNED_CHAR : VTK_UNSIGNED_CHAR;
+}
+
+bool unpackPixels(const PixelFormat& format, const void* source, int rows, int columns,
+                  bool rescale, int intercept, void* dest, UnpackResult& result)
+{
+    if (!format.isSupported() || !source || !dest || rows <= 0 || columns <= 0) return false;
+
+    KernelParams params{};
+    params.source = source;
+    params.dest = dest;
+    params.rows = rows;
+    params.columns = columns;
+
+    if (!format.isMonochrome()) {
+        const std::size_t index = (format.planarConfiguration == 1 ? ColorPlanar : 0)
+                                | (format.photometric == Photometric::YbrFull ? ColorYbr : 0);
+        ColorKernels[index](params);
+        result.minValue = params.minValue;
+        result.maxValue = params.maxValue;
+        result.counts = models::ValueCounts();
+        return true;
+    }
+
+    const int offset = rescale ? intercept : 0;
+    QVector<quint32> counts(1 << format.bitsStored, 0);
+
+    params.shift = format.highBit + 1 - format.bitsStored;
+    params.mask = static_cast<qint32>((1u << format.bitsStored) - 1u);
+    params.signBit = format.isSigned ? (1 << (format.bitsStored - 1)) : 0;
+    params.storedMin = format.storedMin();
+    params.intercept = offset;
+    params.counts = counts.data();
+
+    const bool swap = format.bitsAllocated == 16 && format.bigEndian != (Q_BYTE_ORDER == Q_BIG_ENDIAN);
+    const std::size_t index = (format.bitsAllocated == 16 ? MonoWide : 0)
+                            | (format.isSigned ? MonoSigned : 0)
+                            | (swap ? MonoSwap : 0)
+                            | (rescale ? MonoRescale : 0);
+    MonoKernels[index](params);
+
+    result.minValue = params.minValue;
+    result.maxValue = params.maxValue;
+    // Keep only the measured range; values outside it have no pixels
+    const int first = params.minValue - offset - format.storedMin();
+    result.counts.firstValue = params.minValue;
+    result.counts.counts = counts.mid(first, params.maxValue - params.minValue + 1);
+    return true;
+}
+
+} // namespace imaging
@@ -0,0 +1,56 @@
+#ifndef PIXELFORMAT_H
+#define PIXELFORMAT_H
+
+#include <QString>
+
+#include "models/Histogram.h"
+
+namespace imaging {
+
+enum class Photometric { Monochrome1, Monochrome2, Rgb, YbrFull, Other };
+
+// How the stored pixels of one frame are laid out (PS3.5 8, PS3.3 C.7.6.3)
+struct PixelFormat {
+    int bitsAllocated = 16;
+    int bitsStored = 16;
+    int highBit = 15;
+    bool isSigned = false;
+    int samplesPerPixel = 1;
+    int planarConfiguration = 0;
+    bool bigEndian = false; // byte order of 16-bit words in the source buffer
+    Photometric photometric = Photometric::Monochrome2;
+
+    static Photometric photometricFromString(const QString& value);
+
+    bool isMonochrome() const;
+    // Has a specialised kernel (otherwise decode through DicomImage)
+    bool isSupported() const;
+    int storedMin() const;
+    int storedMax() const;
+};
+
+// Modality rescale folded into the unpack pass: only when it is exact in
+// int16 (slope 1, integral intercept, whole stored range fits)
+bool canRescaleToInt16(const PixelFormat& format, double slope, double intercept);
+
+// VTK scalar type the kernel writes
+int outputScalarType(const PixelFormat& format, bool rescale);
+
+struct UnpackResult {
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    models::ValueCounts counts; // monochrome only, exact per value over [minValue, maxValue]
+};
+
+// One pass over a top-down DICOM frame: unpack/byte-swap, mask to
+// BitsStored, sign-extend, optional integer rescale, flip rows into VTK's
+// bottom-up order (interleaving planar color), value counts and min/max.
+// The kernel is picked once from a constexpr table, so the inner loops
+// carry no per-pixel format branches. `dest` holds rows * columns *
+// (1 or 3) values of outputScalarType().
+bool unpackPixels(const PixelFormat& format, const void* source, int rows, int columns,
+                  bool rescale, int intercept, void* dest, UnpackResult& result);
+
+} // namespace imaging
+
+#endif // PIXELFORMAT_H
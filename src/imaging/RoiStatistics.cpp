@@ -0,0 +1,366 @@
+#include "RoiStatistics.h"
+#include "ParallelFor.h"
+
+#include <vtkImageData.h>
+#include <vtkSetGet.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <variant>
+
+namespace imaging {
+
+namespace {
+
+constexpr int BlockSize = 32;
+// A 512 x 512 CT slice needs ~4 MB of tables, a 4k x 4k mammogram ~270 MB
+constexpr std::size_t MaxCachedBytes = std::size_t(320) << 20;
+
+// Exact integer sums for integer pixels, double otherwise
+template<typename T>
+using SumType = typename std::conditional<std::is_integral<T>::value, qint64, double>::type;
+
+template<typename Acc>
+Acc rectSum(const std::vector<Acc>& table, std::size_t stride, int x0, int y0, int x1, int y1)
+{
+    return table[(y1 + 1) * stride + x1 + 1] - table[y0 * stride + x1 + 1]
+         - table[(y1 + 1) * stride + x0] + table[y0 * stride + x0];
+}
+
+// Two parallel passes: running sums along rows (plus min/max blocks), then
+// accumulation down the columns with column ranges split across threads
+template<typename T, typename Acc>
+void buildTables(const T* pixels, int width, int height, QThreadPool* pool,
+                 std::vector<Acc>& sum, std::vector<Acc>& sumSq,
+                 std::vector<double>& blockMin, std::vector<double>& blockMax)
+{
+    const std::size_t stride = static_cast<std::size_t>(width) + 1;
+    const int blocks = (width + BlockSize - 1) / BlockSize;
+    sum.assign(stride * (height + 1), Acc(0));
+    sumSq.assign(stride * (height + 1), Acc(0));
+    blockMin.resize(static_cast<std::size_t>(blocks) * height);
+    blockMax.resize(static_cast<std::size_t>(blocks) * height);
+
+    parallelFor(pool, 0, height, 16, [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            const T* row = pixels + static_cast<std::size_t>(y) * width;
+            Acc* rowSum = sum.data() + (y + 1) * stride + 1;
+            Acc* rowSumSq = sumSq.data() + (y + 1) * stride + 1;
+
+            Acc running = 0;
+            Acc runningSq = 0;
+            for (int x = 0; x < width; ++x) {
+                const Acc value = static_cast<Acc>(row[x]);
+                running += value;
+                runningSq += value * value;
+                rowSum[x] = running;
+                rowSumSq[x] = runningSq;
+            }
+
+            for (int b = 0; b < blocks; ++b) {
+                const T* begin = row + b * BlockSize;
+                const T* end = row + std::min(width, (b + 1) * BlockSize);
+                const auto range = std::minmax_element(begin, end);
+                blockMin[static_cast<std::size_t>(y) * blocks + b] = *range.first;
+                blockMax[static_cast<std::size_t>(y) * blocks + b] = *range.second;
+            }
+        }
+    });
+
+    parallelFor(pool, 1, width + 1, 256, [&](int first, int last) {
+        for (int y = 2; y <= height; ++y) {
+            Acc* rowSum = sum.data() + y * stride;
+            Acc* rowSumSq = sumSq.data() + y * stride;
+            const Acc* aboveSum = rowSum - stride;
+            const Acc* aboveSumSq = rowSumSq - stride;
+            for (int x = first; x < last; ++x) {
+                rowSum[x] += aboveSum[x];
+                rowSumSq[x] += aboveSumSq[x];
+            }
+        }
+    });
+}
+
+// Whole blocks come from the block table, the ragged ends from the pixels
+template<typename T>
+void spanMinMax(const T* pixels, int width, const std::vector<double>& blockMin,
+                const std::vector<double>& blockMax, const QVector<RowSpan>& spans,
+                double& minValue, double& maxValue)
+{
+    const int blocks = (width + BlockSize - 1) / BlockSize;
+    for (const RowSpan& span : spans) {
+        const T* row = pixels + static_cast<std::size_t>(span.y) * width;
+        const int firstBlock = (span.x0 + BlockSize - 1) / BlockSize;
+        const int endBlock = (span.x1 + 1) / BlockSize;
+
+        auto scan = [&](int from, int to) {
+            for (int x = from; x <= to; ++x) {
+                minValue = std::min(minValue, static_cast<double>(row[x]));
+                maxValue = std::max(maxValue, static_cast<double>(row[x]));
+            }
+        };
+
+        if (firstBlock >= endBlock) {
+            scan(span.x0, span.x1);
+            continue;
+        }
+        scan(span.x0, firstBlock * BlockSize - 1);
+        for (int b = firstBlock; b < endBlock; ++b) {
+            minValue = std::min(minValue, blockMin[static_cast<std::size_t>(span.y) * blocks + b]);
+            maxValue = std::max(maxValue, blockMax[static_cast<std::size_t>(span.y) * blocks + b]);
+        }
+        scan(endBlock * BlockSize, span.x1);
+    }
+}
+
+} // namespace
+
+// (width + 1) x (height + 1) with a zero first row and column
+template<typename Acc>
+struct SumTables {
+    std::vector<Acc> sum;
+    std::vector<Acc> sumSq;
+};
+
+struct RoiStatistics::SliceTables {
+    int slice = -1;
+    // Exact int64 for integer pixels, double otherwise; only one is allocated
+    std::variant<SumTables<qint64>, SumTables<double>> sums;
+    // ceil(width / BlockSize) entries per row
+    std::vector<double> blockMin;
+    std::vector<double> blockMax;
+
+    std::size_t bytes() const
+    {
+        const std::size_t sumBytes = std::visit([](const auto& t) {
+            return (t.sum.size() + t.sumSq.size()) * sizeof(t.sum[0]);
+        }, sums);
+        return sumBytes + (blockMin.size() + blockMax.size()) * sizeof(double);
+    }
+};
+
+QVector<RowSpan> ellipseSpans(const QRectF& bounds, int width, int height)
+{
+    QVector<RowSpan> spans;
+    const QRectF box = bounds.normalized();
+    const double rx = box.width() / 2.0;
+    const double ry = box.height() / 2.0;
+    if (rx <= 0.0 || ry <= 0.0) return spans;
+
+    const QPointF centre = box.center();
+    const int yBegin = std::max(0, static_cast<int>(std::ceil(centre.y() - ry)));
+    const int yEnd = std::min(height - 1, static_cast<int>(std::floor(centre.y() + ry)));
+    for (int y = yBegin; y <= yEnd; ++y) {
+        const double dy = (y - centre.y()) / ry;
+        const double half = rx * std::sqrt(std::max(0.0, 1.0 - dy * dy));
+        const int x0 = std::max(0, static_cast<int>(std::ceil(centre.x() - half)));
+        const int x1 = std::min(width - 1, static_cast<int>(std::floor(centre.x() + half)));
+        if (x0 <= x1) spans.append({y, x0, x1});
+    }
+    return spans;
+}
+
+QVector<RowSpan> polygonSpans(const QPolygonF& polygon, int width, int height)
+{
+    QVector<RowSpan> spans;
+    if (polygon.size() < 3) return spans;
+
+    const QRectF box = polygon.boundingRect();
+    const int yBegin = std::max(0, static_cast<int>(std::ceil(box.top())));
+    const int yEnd = std::min(height - 1, static_cast<int>(std::floor(box.bottom())));
+
+    // Even-odd scanline fill through pixel centres
+    QVector<double> crossings;
+    for (int y = yBegin; y <= yEnd; ++y) {
+        crossings.clear();
+        for (int i = 0; i < polygon.size(); ++i) {
+            const QPointF& a = polygon[i];
+            const QPointF& b = polygon[(i + 1) % polygon.size()];
+            if ((a.y() <= y) != (b.y() <= y)) {
+                crossings.append(a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y()));
+            }
+        }
+        std::sort(crossings.begin(), crossings.end());
+        // Where edges cross on a pixel centre (self-intersection) two spans
+        // would share that pixel: count it once
+        int covered = -1;
+        for (int i = 0; i + 1 < crossings.size(); i += 2) {
+            const int x0 = std::max({0, covered + 1, static_cast<int>(std::ceil(crossings[i]))});
+            const int x1 = std::min(width - 1, static_cast<int>(std::floor(crossings[i + 1])));
+            if (x0 <= x1) {
+                spans.append({y, x0, x1});
+                covered = x1;
+            }
+        }
+    }
+    return spans;
+}
+
+RoiStatistics::RoiStatistics(vtkImageData* image, double rescaleSlope, double rescaleIntercept,
+                             double spacingX, double spacingY, QThreadPool* pool)
+    : m_image(image)
+    , m_slope(rescaleSlope != 0.0 ? rescaleSlope : 1.0)
+    , m_intercept(rescaleIntercept)
+    , m_pixelArea(spacingX * spacingY)
+    , m_pool(pool)
+{
+    if (m_image && m_image->GetNumberOfScalarComponents() == 1) {
+        int dims[3];
+        m_image->GetDimensions(dims);
+        m_width = dims[0];
+        m_height = dims[1];
+        m_slices = dims[2];
+    }
+}
+
+RoiStatistics::~RoiStatistics() = default;
+
+void RoiStatistics::invalidate()
+{
+    m_cache.clear();
+}
+
+const RoiStatistics::SliceTables* RoiStatistics::tables(int slice)
+{
+    if (slice < 0 || slice >= m_slices) return nullptr;
+
+    for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+        if ((*it)->slice == slice) {
+            std::rotate(it, it + 1, m_cache.end());
+            return m_cache.back().get();
+        }
+    }
+
+    auto entry = std::make_unique<SliceTables>();
+    entry->slice = slice;
+    const void* pixels = m_image->GetScalarPointer(0, 0, slice);
+
+    switch (m_image->GetScalarType()) {
+        vtkTemplateMacro(
+            using Tables = SumTables<SumType<VTK_TT>>;
+            Tables& sums = entry->sums.emplace<Tables>();
+            buildTables(static_cast<const VTK_TT*>(pixels), m_width, m_height, m_pool,
+                        sums.sum, sums.sumSq, entry->blockMin, entry->blockMax));
+    default:
+        return nullptr;
+    }
+
+    // Evict least recently used slices until the new one fits the budget;
+    // the slice being measured is always kept
+    std::size_t bytes = entry->bytes();
+    for (const auto& cached : m_cache) {
+        bytes += cached->bytes();
+    }
+    while (!m_cache.empty() && bytes > MaxCachedBytes) {
+        bytes -= m_cache.front()->bytes();
+        m_cache.erase(m_cache.begin());
+    }
+    m_cache.push_back(std::move(entry));
+    return m_cache.back().get();
+}
+
+RoiStats RoiStatistics::rectangle(int slice, int x0, int y0, int x1, int y1)
+{
+    const int left = std::max(0, std::min(x0, x1));
+    const int right = std::min(m_width - 1, std::max(x0, x1));
+    const int bottom = std::max(0, std::min(y0, y1));
+    const int top = std::min(m_height - 1, std::max(y0, y1));
+    if (left > right || bottom > top) return RoiStats();
+
+    QVector<RowSpan> rows;
+    rows.reserve(top - bottom + 1);
+    for (int y = bottom; y <= top; ++y) {
+        rows.append({y, left, right});
+    }
+
+    const SliceTables* t = tables(slice);
+    if (!t) return RoiStats();
+
+    // Mean/SD straight from the four table corners
+    const std::size_t stride = static_cast<std::size_t>(m_width) + 1;
+    const qint64 count = static_cast<qint64>(right - left + 1) * (top - bottom + 1);
+    double sum = 0.0;
+    double sumSq = 0.0;
+    std::visit([&](const auto& sums) {
+        sum = static_cast<double>(rectSum(sums.sum, stride, left, bottom, right, top));
+        sumSq = static_cast<double>(rectSum(sums.sumSq, stride, left, bottom, right, top));
+    }, t->sums);
+
+    double minValue = std::numeric_limits<double>::max();
+    double maxValue = std::numeric_limits<double>::lowest();
+    switch (m_image->GetScalarType()) {
+        vtkTemplateMacro(spanMinMax(static_cast<const VTK_TT*>(m_image->GetScalarPointer(0, 0, slice)),
+                                    m_width, t->blockMin, t->blockMax, rows, minValue, maxValue));
+    default:
+        break;
+    }
+
+    return finish(count, sum, sumSq, minValue, maxValue);
+}
+
+RoiStats RoiStatistics::ellipse(int slice, const QRectF& bounds)
+{
+    return spans(slice, ellipseSpans(bounds, m_width, m_height));
+}
+
+RoiStats RoiStatistics::polygon(int slice, const QPolygonF& polygon)
+{
+    return spans(slice, polygonSpans(polygon, m_width, m_height));
+}
+
+RoiStats RoiStatistics::spans(int slice, const QVector<RowSpan>& spans)
+{
+    const SliceTables* t = tables(slice);
+    if (!t || spans.isEmpty()) return RoiStats();
+
+    const std::size_t stride = static_cast<std::size_t>(m_width) + 1;
+    qint64 count = 0;
+    double sum = 0.0;
+    double sumSq = 0.0;
+    std::visit([&](const auto& sums) {
+        // Accumulate in the table type: exact for integer pixels
+        using Acc = typename std::decay_t<decltype(sums.sum)>::value_type;
+        Acc spanSum = 0;
+        Acc spanSumSq = 0;
+        for (const RowSpan& span : spans) {
+            count += span.x1 - span.x0 + 1;
+            spanSum += rectSum(sums.sum, stride, span.x0, span.y, span.x1, span.y);
+            spanSumSq += rectSum(sums.sumSq, stride, span.x0, span.y, span.x1, span.y);
+        }
+        sum = static_cast<double>(spanSum);
+        sumSq = static_cast<double>(spanSumSq);
+    }, t->sums);
+
+    double minValue = std::numeric_limits<double>::max();
+    double maxValue = std::numeric_limits<double>::lowest();
+    switch (m_image->GetScalarType()) {
+        vtkTemplateMacro(spanMinMax(static_cast<const VTK_TT*>(m_image->GetScalarPointer(0, 0, slice)),
+                                    m_width, t->blockMin, t->blockMax, spans, minValue, maxValue));
+    default:
+        break;
+    }
+
+    return finish(count, sum, sumSq, minValue, maxValue);
+}
+
+RoiStats RoiStatistics::finish(qint64 count, double sum, double sumSq, double minValue, double maxValue) const
+{
+    RoiStats stats;
+    if (count <= 0) return stats;
+
+    // Sample SD of the stored values, then into modality units
+    const double mean = sum / count;
+    const double variance = count > 1 ? std::max(0.0, (sumSq - sum * mean) / (count - 1)) : 0.0;
+
+    stats.pixelCount = count;
+    stats.mean = mean * m_slope + m_intercept;
+    stats.stdDev = std::sqrt(variance) * std::abs(m_slope);
+    stats.minValue = (m_slope >= 0.0 ? minValue : maxValue) * m_slope + m_intercept;
+    stats.maxValue = (m_slope >= 0.0 ? maxValue : minValue) * m_slope + m_intercept;
+    stats.areaMm2 = count * m_pixelArea;
+    return stats;
+}
+
+} // namespace imaging
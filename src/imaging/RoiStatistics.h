@@ -0,0 +1,86 @@
+#ifndef ROISTATISTICS_H
+#define ROISTATISTICS_H
+
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector>
+
+#include <vtkSmartPointer.h>
+
+#include <memory>
+#include <vector>
+
+class QThreadPool;
+class vtkImageData;
+
+namespace imaging {
+
+// Values are in modality units (HU for CT), area in mm²
+struct RoiStats {
+    qint64 pixelCount = 0;
+    double mean = 0.0;
+    double stdDev = 0.0;
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    double areaMm2 = 0.0;
+
+    bool isValid() const { return pixelCount > 0; }
+};
+
+// Inclusive run of pixels [x0, x1] on row y (vtkImageData indices)
+struct RowSpan {
+    int y;
+    int x0;
+    int x1;
+};
+
+// Pixels whose centre lies inside the shape, clipped to width x height.
+// Coordinates are in pixel units with pixel centres on integers.
+QVector<RowSpan> ellipseSpans(const QRectF& bounds, int width, int height);
+QVector<RowSpan> polygonSpans(const QPolygonF& polygon, int width, int height);
+
+// ROI statistics over one slice of a single-component image. Summed-area
+// tables of values and squared values (exact int64 for integer data) are
+// built lazily per slice, in parallel, on first use, and the most recently
+// measured slices are kept within a fixed memory budget. After that a rectangle's
+// mean/SD costs O(1) and an ellipse or freehand shape O(rows). Min/max
+// come from per-row blocks of 32 pixels. Not thread-safe: use it from the
+// thread that owns the viewer.
+class RoiStatistics
+{
+public:
+    RoiStatistics(vtkImageData* image, double rescaleSlope, double rescaleIntercept,
+                  double spacingX, double spacingY, QThreadPool* pool);
+    ~RoiStatistics();
+
+    RoiStats rectangle(int slice, int x0, int y0, int x1, int y1);
+    RoiStats ellipse(int slice, const QRectF& bounds);
+    RoiStats polygon(int slice, const QPolygonF& polygon);
+    RoiStats spans(int slice, const QVector<RowSpan>& spans);
+
+    vtkImageData* image() const { return m_image; }
+
+    // Drops the cached tables (image rewritten in place)
+    void invalidate();
+
+private:
+    struct SliceTables;
+    const SliceTables* tables(int slice);
+    RoiStats finish(qint64 count, double sum, double sumSq, double minValue, double maxValue) const;
+
+    vtkSmartPointer<vtkImageData> m_image;
+    double m_slope;
+    double m_intercept;
+    double m_pixelArea;
+    QThreadPool* m_pool;
+    int m_width = 0;
+    int m_height = 0;
+    int m_slices = 0;
+
+    // Most recently used last; evicted by total table size
+    std::vector<std::unique_ptr<SliceTables>> m_cache;
+};
+
+} // namespace imaging
+
+#endif // ROISTATISTICS_H
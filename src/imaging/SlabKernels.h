@@ -0,0 +1,232 @@
+#ifndef SLABKERNELS_H
+#define SLABKERNELS_H
+
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace imaging {
+
+enum class ProjectionMode { Maximum, Minimum, Average };
+enum class SlabAxis { X = 0, Y = 1, Z = 2 };
+
+struct SlabParams {
+    ProjectionMode mode = ProjectionMode::Maximum;
+    SlabAxis axis = SlabAxis::Z;
+    int position = 0;   // centre slice along the axis
+    int thickness = 1;  // in slices
+};
+
+// Output plane of a slab along `axis`: Z -> (x, y), Y -> (x, z), X -> (y, z).
+inline void slabOutputSize(const int dims[3], SlabAxis axis, int& width, int& height)
+{
+    width = dims[0];
+    height = dims[1];
+    switch (axis) {
+    case SlabAxis::Z: width = dims[0]; height = dims[1]; break;
+    case SlabAxis::Y: width = dims[0]; height = dims[2]; break;
+    case SlabAxis::X: width = dims[1]; height = dims[2]; break;
+    }
+}
+
+// Clamped [first, last) range of slices covered by the slab.
+inline void slabRange(const int dims[3], const SlabParams& params, int& first, int& last)
+{
+    const int count = dims[static_cast<int>(params.axis)];
+    const int thickness = std::max(1, params.thickness);
+    first = std::max(0, params.position - thickness / 2);
+    last = std::min(count, first + thickness);
+    first = std::max(0, std::min(first, last - 1));
+}
+
+namespace detail {
+
+// The reductions below are written as branch-free loops over contiguous,
+// non-aliasing spans so that the compiler emits packed min/max/add
+// (SSE2/AVX2 on x86, NEON on ARM) without per-ISA intrinsics.
+template<typename T> struct MaxOp { static T apply(T a, T b) { return a < b ? b : a; } };
+template<typename T> struct MinOp { static T apply(T a, T b) { return b < a ? b : a; } };
+
+template<typename T>
+using SumType = typename std::conditional<std::is_floating_point<T>::value, double,
+                typename std::conditional<(sizeof(T) <= 2), std::int32_t, std::int64_t>::type>::type;
+
+template<typename T, typename Op>
+inline void reduceRow(T* __restrict acc, const T* __restrict src, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        acc[i] = Op::apply(acc[i], src[i]);
+    }
+}
+
+template<typename T, typename Acc>
+inline void sumRow(Acc* __restrict acc, const T* __restrict src, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        acc[i] += static_cast<Acc>(src[i]);
+    }
+}
+
+template<typename T, typename Acc>
+inline T meanOf(Acc sum, double inverse)
+{
+    if (std::is_floating_point<T>::value) {
+        return static_cast<T>(sum * inverse);
+    }
+    return static_cast<T>(std::floor(sum * inverse + 0.5));
+}
+
+template<typename T, typename Acc>
+inline void storeMean(T* __restrict out, const Acc* __restrict acc, int n, double inverse)
+{
+    for (int i = 0; i < n; ++i) {
+        out[i] = meanOf<T>(acc[i], inverse);
+    }
+}
+
+template<typename T, typename Op>
+inline T reduceSpan(const T* __restrict src, int n)
+{
+    T result = src[0];
+    for (int i = 1; i < n; ++i) {
+        result = Op::apply(result, src[i]);
+    }
+    return result;
+}
+
+template<typename T, typename Acc>
+inline Acc sumSpan(const T* __restrict src, int n)
+{
+    Acc result = 0;
+    for (int i = 0; i < n; ++i) {
+        result += static_cast<Acc>(src[i]);
+    }
+    return result;
+}
+
+// Z and Y slabs: the reduction runs across whole x rows (vertical SIMD).
+// `rowOf(outRow, k)` returns the source row for output row `outRow` and
+// slab index k. When `contiguous` is set (axial slabs) consecutive output
+// rows are consecutive in every source slice, so a chunk of rows is reduced
+// as one long span instead of row by row.
+template<typename T, typename Op, typename RowOf>
+void projectRows(int outRows, int width, int first, int last, bool contiguous, RowOf rowOf,
+                 T* output, QThreadPool* pool)
+{
+    parallelFor(pool, 0, outRows, 8, [&](int rowBegin, int rowEnd) {
+        const int step = contiguous ? rowEnd - rowBegin : 1;
+        const int span = width * step;
+        for (int r = rowBegin; r < rowEnd; r += step) {
+            T* out = output + static_cast<std::size_t>(r) * width;
+            std::memcpy(out, rowOf(r, first), sizeof(T) * span);
+            for (int k = first + 1; k < last; ++k) {
+                reduceRow<T, Op>(out, rowOf(r, k), span);
+            }
+        }
+    });
+}
+
+template<typename T, typename RowOf>
+void averageRows(int outRows, int width, int first, int last, bool contiguous, RowOf rowOf,
+                 T* output, QThreadPool* pool)
+{
+    using Acc = SumType<T>;
+    const double inverse = 1.0 / (last - first);
+
+    parallelFor(pool, 0, outRows, 8, [&](int rowBegin, int rowEnd) {
+        const int step = contiguous ? rowEnd - rowBegin : 1;
+        const int span = width * step;
+        std::vector<Acc> acc(span);
+        for (int r = rowBegin; r < rowEnd; r += step) {
+            std::fill(acc.begin(), acc.end(), Acc(0));
+            for (int k = first; k < last; ++k) {
+                sumRow(acc.data(), rowOf(r, k), span);
+            }
+            storeMean(output + static_cast<std::size_t>(r) * width, acc.data(), span, inverse);
+        }
+    });
+}
+
+// X slabs (sagittal): the slab is a contiguous span inside each x row, so
+// every output pixel is one horizontal reduction. The reduction is a
+// template parameter so the mode is resolved once per call.
+template<typename T> struct MaxSpan {
+    static T apply(const T* src, int n, double) { return reduceSpan<T, MaxOp<T>>(src, n); }
+};
+template<typename T> struct MinSpan {
+    static T apply(const T* src, int n, double) { return reduceSpan<T, MinOp<T>>(src, n); }
+};
+template<typename T> struct MeanSpan {
+    static T apply(const T* src, int n, double inverse) { return meanOf<T>(sumSpan<T, SumType<T>>(src, n), inverse); }
+};
+
+template<typename T, typename SpanOp>
+void projectSpans(const T* volume, const int dims[3], int first, int last, T* output, QThreadPool* pool)
+{
+    const std::size_t nx = dims[0];
+    const std::size_t ny = dims[1];
+    const int span = last - first;
+    const int width = dims[1];
+    const int height = dims[2];
+    const double inverse = 1.0 / span;
+
+    parallelFor(pool, 0, height, 4, [&](int zBegin, int zEnd) {
+        for (int z = zBegin; z < zEnd; ++z) {
+            T* out = output + static_cast<std::size_t>(z) * width;
+            for (int y = 0; y < width; ++y) {
+                out[y] = SpanOp::apply(volume + (z * ny + y) * nx + first, span, inverse);
+            }
+        }
+    });
+}
+
+} // namespace detail
+
+// Thick-slab projection of a contiguous x-fastest volume into `output`
+// (slabOutputSize() values). Parallelised over output rows.
+template<typename T>
+void projectSlab(const T* volume, const int dims[3], const SlabParams& params, T* output, QThreadPool* pool)
+{
+    const std::size_t nx = dims[0];
+    const std::size_t ny = dims[1];
+    int first, last;
+    slabRange(dims, params, first, last);
+
+    if (params.axis == SlabAxis::X) {
+        switch (params.mode) {
+        case ProjectionMode::Maximum: detail::projectSpans<T, detail::MaxSpan<T>>(volume, dims, first, last, output, pool); break;
+        case ProjectionMode::Minimum: detail::projectSpans<T, detail::MinSpan<T>>(volume, dims, first, last, output, pool); break;
+        case ProjectionMode::Average: detail::projectSpans<T, detail::MeanSpan<T>>(volume, dims, first, last, output, pool); break;
+        }
+        return;
+    }
+
+    int width, height;
+    slabOutputSize(dims, params.axis, width, height);
+
+    auto axialRow = [&](int y, int z) { return volume + (z * ny + y) * nx; };
+    auto coronalRow = [&](int z, int y) { return volume + (z * ny + y) * nx; };
+
+    if (params.axis == SlabAxis::Z) {
+        switch (params.mode) {
+        case ProjectionMode::Maximum: detail::projectRows<T, detail::MaxOp<T>>(height, width, first, last, true, axialRow, output, pool); break;
+        case ProjectionMode::Minimum: detail::projectRows<T, detail::MinOp<T>>(height, width, first, last, true, axialRow, output, pool); break;
+        case ProjectionMode::Average: detail::averageRows<T>(height, width, first, last, true, axialRow, output, pool); break;
+        }
+    } else {
+        switch (params.mode) {
+        case ProjectionMode::Maximum: detail::projectRows<T, detail::MaxOp<T>>(height, width, first, last, false, coronalRow, output, pool); break;
+        case ProjectionMode::Minimum: detail::projectRows<T, detail::MinOp<T>>(height, width, first, last, false, coronalRow, output, pool); break;
+        case ProjectionMode::Average: detail::averageRows<T>(height, width, first, last, false, coronalRow, output, pool); break;
+        }
+    }
+}
+
+} // namespace imaging
+
+#endif // SLABKERNELS_H
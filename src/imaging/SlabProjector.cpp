@@ -0,0 +1,52 @@
+#include "SlabProjector.h"
+
+#include <vtkImageData.h>
+#include <vtkSetGet.h>
+
+namespace imaging {
+
+vtkSmartPointer<vtkImageData> projectSlab(vtkImageData* volume, const SlabParams& params,
+                                          QThreadPool* pool, vtkImageData* reuse)
+{
+    if (!volume || volume->GetNumberOfPoints() == 0 || volume->GetNumberOfScalarComponents() != 1) {
+        return nullptr;
+    }
+
+    int dims[3];
+    volume->GetDimensions(dims);
+    int width, height;
+    slabOutputSize(dims, params.axis, width, height);
+
+    double spacing[3];
+    double origin[3];
+    volume->GetSpacing(spacing);
+    volume->GetOrigin(origin);
+
+    // In-plane axes of the output, in (column, row) order
+    const int columnAxis = params.axis == SlabAxis::X ? 1 : 0;
+    const int rowAxis = params.axis == SlabAxis::Z ? 1 : 2;
+
+    vtkSmartPointer<vtkImageData> output = reuse;
+    int reuseDims[3] = {0, 0, 0};
+    if (output) output->GetDimensions(reuseDims);
+    if (!output || reuseDims[0] != width || reuseDims[1] != height || reuseDims[2] != 1 ||
+        output->GetScalarType() != volume->GetScalarType()) {
+        output = vtkSmartPointer<vtkImageData>::New();
+        output->SetDimensions(width, height, 1);
+        output->AllocateScalars(volume->GetScalarType(), 1);
+    }
+    output->SetSpacing(spacing[columnAxis], spacing[rowAxis], spacing[params.axis == SlabAxis::Z ? 2 : 1]);
+    output->SetOrigin(origin[columnAxis], origin[rowAxis], 0.0);
+
+    switch (volume->GetScalarType()) {
+        vtkTemplateMacro(projectSlab(static_cast<const VTK_TT*>(volume->GetScalarPointer()), dims, params,
+                                     static_cast<VTK_TT*>(output->GetScalarPointer()), pool));
+    default:
+        return nullptr;
+    }
+
+    output->Modified();
+    return output;
+}
+
+} // namespace imaging
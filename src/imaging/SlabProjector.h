@@ -0,0 +1,22 @@
+#ifndef SLABPROJECTOR_H
+#define SLABPROJECTOR_H
+
+#include "SlabKernels.h"
+
+#include <vtkSmartPointer.h>
+
+class QThreadPool;
+class vtkImageData;
+
+namespace imaging {
+
+// Thick-slab MIP/MinIP/average of a single-component volume. The result is
+// a one-slice image in the plane perpendicular to params.axis, with the
+// source scalar type and in-plane spacing. `reuse` is recycled when its
+// geometry still matches, so dragging the thickness does not reallocate.
+vtkSmartPointer<vtkImageData> projectSlab(vtkImageData* volume, const SlabParams& params,
+                                          QThreadPool* pool, vtkImageData* reuse = nullptr);
+
+} // namespace imaging
+
+#endif // SLABPROJECTOR_H
@@ -0,0 +1,42 @@
+#include "WindowLevel.h"
+
+namespace imaging {
+
+VoiSettings VoiSettings::fromMetadata(const models::DicomMetadata& metadata, double window, double level,
+                                      bool useDatasetLut)
+{
+    VoiSettings voi;
+    voi.window = window;
+    voi.level = level;
+
+    if (metadata.samplesPerPixel > 1) {
+        return voi;
+    }
+
+    voi.rescaleSlope = metadata.rescaleSlope != 0.0 ? metadata.rescaleSlope : 1.0;
+    voi.rescaleIntercept = metadata.rescaleIntercept;
+
+    if (metadata.voiLutFunction == QLatin1String("LINEAR_EXACT")) {
+        voi.function = Function::LinearExact;
+    } else if (metadata.voiLutFunction == QLatin1String("SIGMOID")) {
+        voi.function = Function::Sigmoid;
+    }
+
+    if (useDatasetLut && !metadata.voiLutData.isEmpty()) {
+        voi.lutData = metadata.voiLutData;
+        voi.lutFirstMapped = metadata.voiLutFirstMapped;
+        voi.lutBits = metadata.voiLutBits;
+    }
+
+    return voi;
+}
+
+bool VoiSettings::operator==(const VoiSettings& other) const
+{
+    return window == other.window && level == other.level && function == other.function &&
+           rescaleSlope == other.rescaleSlope && rescaleIntercept == other.rescaleIntercept &&
+           lutFirstMapped == other.lutFirstMapped && lutBits == other.lutBits &&
+           lutData == other.lutData;
+}
+
+} // namespace imaging
@@ -0,0 +1,104 @@
+#ifndef WINDOWLEVEL_H
+#define WINDOWLEVEL_H
+
+#include <QVector>
+
+#include "models/DicomMetadata.h"
+
+#include <limits>
+
+namespace imaging {
+
+// CPU window/level to 8-bit, replicating vtkImageMapToWindowLevelColors
+// (no lookup table) bit for bit.
+template<typename T>
+struct WindowLevelClamps {
+    T lower;
+    T upper;
+    unsigned char lowerValue;
+    unsigned char upperValue;
+    double shift;
+    double scale;
+
+    WindowLevelClamps(double window, double level)
+    {
+        const double typeMin = static_cast<double>(std::numeric_limits<T>::lowest());
+        const double typeMax = static_cast<double>(std::numeric_limits<T>::max());
+
+        const double fLower = level - (window < 0 ? -window : window) / 2.0;
+        const double fUpper = fLower + (window < 0 ? -window : window);
+
+        double adjustedLower, adjustedUpper;
+        if (fLower <= typeMax) {
+            adjustedLower = (fLower >= typeMin) ? fLower : typeMin;
+        } else {
+            adjustedLower = typeMax;
+        }
+        if (fUpper >= typeMin) {
+            adjustedUpper = (fUpper <= typeMax) ? fUpper : typeMax;
+        } else {
+            adjustedUpper = typeMin;
+        }
+        lower = static_cast<T>(adjustedLower);
+        upper = static_cast<T>(adjustedUpper);
+
+        double fLowerValue, fUpperValue;
+        if (window >= 0) {
+            fLowerValue = 255.0 * (adjustedLower - fLower) / window;
+            fUpperValue = 255.0 * (adjustedUpper - fLower) / window;
+        } else {
+            fLowerValue = 255.0 + 255.0 * (adjustedLower - fLower) / window;
+            fUpperValue = 255.0 + 255.0 * (adjustedUpper - fLower) / window;
+        }
+        lowerValue = clampToByte(fLowerValue);
+        upperValue = clampToByte(fUpperValue);
+
+        shift = window / 2.0 - level;
+        scale = 255.0 / window;
+    }
+
+    unsigned char map(T value) const
+    {
+        if (value <= lower) return lowerValue;
+        if (value >= upper) return upperValue;
+        return static_cast<unsigned char>((value + shift) * scale);
+    }
+
+private:
+    static unsigned char clampToByte(double v)
+    {
+        if (v > 255) return 255;
+        if (v < 0) return 0;
+        return static_cast<unsigned char>(v);
+    }
+};
+
+// Grayscale display pipeline (PS3.3 C.11): stored value -> modality
+// rescale -> VOI LUT or VOI function -> 8 bits. Window and level are in
+// modality units (HU for CT). LINEAR keeps the clamping above, so it
+// matches what vtkImageMapToWindowLevelColors produced before.
+struct VoiSettings {
+    enum class Function { Linear, LinearExact, Sigmoid };
+
+    double window = 255.0;
+    double level = 127.5;
+    Function function = Function::Linear;
+    double rescaleSlope = 1.0;
+    double rescaleIntercept = 0.0;
+
+    // VOI LUT Sequence item; replaces the window function when not empty
+    QVector<quint16> lutData;
+    int lutFirstMapped = 0;
+    int lutBits = 16;
+
+    // Color images skip rescale and VOI: only the window applies
+    static VoiSettings fromMetadata(const models::DicomMetadata& metadata, double window, double level,
+                                    bool useDatasetLut = false);
+
+    bool operator==(const VoiSettings& other) const;
+    bool operator!=(const VoiSettings& other) const { return !(*this == other); }
+};
+
+} // namespace imaging
+
+#endif // WINDOWLEVEL_H
@@ -0,0 +1,204 @@
+#include "WindowLevelLut.h"
+#include "ParallelFor.h"
+
+#include <vtkImageData.h>
+#include <vtkSetGet.h>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace imaging {
+
+namespace {
+
+template<typename T>
+constexpr bool usesTable()
+{
+    return std::is_integral<T>::value && sizeof(T) <= 2;
+}
+
+// One VOI evaluation: rescale, then VOI LUT or window function
+class VoiEvaluator
+{
+public:
+    explicit VoiEvaluator(const VoiSettings& settings)
+        : m_settings(settings)
+        , m_clamps(settings.window, settings.level)
+        , m_lutScale(255.0 / ((1 << settings.lutBits) - 1))
+    {
+    }
+
+    unsigned char operator()(double stored) const
+    {
+        const double value = stored * m_settings.rescaleSlope + m_settings.rescaleIntercept;
+
+        // Values outside the LUT clamp to its first/last entry. The empty
+        // check must stay next to the clamp: lastEntry is -1 without it
+        if (!m_settings.lutData.isEmpty()) {
+            const int lastEntry = static_cast<int>(m_settings.lutData.size()) - 1;
+            const int index = std::min(std::max(static_cast<int>(std::floor(value + 0.5)) - m_settings.lutFirstMapped, 0),
+                                       lastEntry);
+            return toByte(m_settings.lutData[index] * m_lutScale);
+        }
+
+        const double window = m_settings.window;
+        const double level = m_settings.level;
+        switch (m_settings.function) {
+        case VoiSettings::Function::LinearExact:
+            if (window <= 0.0) return value > level ? 255 : 0;
+            return toByte(((value - level) / window + 0.5) * 255.0);
+        case VoiSettings::Function::Sigmoid:
+            if (window <= 0.0) return value > level ? 255 : 0;
+            return toByte(255.0 / (1.0 + std::exp(-4.0 * (value - level) / window)));
+        case VoiSettings::Function::Linear:
+            break;
+        }
+        return m_clamps.map(value);
+    }
+
+private:
+    static unsigned char toByte(double v)
+    {
+        if (v <= 0.0) return 0;
+        if (v >= 255.0) return 255;
+        return static_cast<unsigned char>(v + 0.5);
+    }
+
+    const VoiSettings& m_settings;
+    WindowLevelClamps<double> m_clamps;
+    double m_lutScale;
+};
+
+template<typename T>
+void fillTable(const VoiSettings& settings, std::vector<unsigned char>& table, int& offset)
+{
+    if constexpr (usesTable<T>()) {
+        const int first = std::numeric_limits<T>::lowest();
+        const int last = std::numeric_limits<T>::max();
+        table.resize(static_cast<std::size_t>(last - first + 1));
+        offset = first;
+
+        // Plain window on raw values: clamp in T exactly like the VTK filter
+        if (settings.function == VoiSettings::Function::Linear && settings.lutData.isEmpty() &&
+            settings.rescaleSlope == 1.0 && settings.rescaleIntercept == 0.0) {
+            const WindowLevelClamps<T> clamps(settings.window, settings.level);
+            for (int value = first; value <= last; ++value) {
+                table[value - first] = clamps.map(static_cast<T>(value));
+            }
+            return;
+        }
+
+        const VoiEvaluator voi(settings);
+        for (int value = first; value <= last; ++value) {
+            table[value - first] = voi(value);
+        }
+    } else {
+        table.clear();
+        offset = 0;
+    }
+}
+
+// A byte table cannot use hardware gathers (they load 32-bit lanes), so the
+// lookup stays a tight scalar loop over a table that lives in L1/L2
+template<typename T>
+void mapTyped(const T* __restrict source, std::size_t count, const VoiSettings& settings,
+              const unsigned char* __restrict table, int offset, unsigned char* __restrict dest)
+{
+    if constexpr (usesTable<T>()) {
+        Q_UNUSED(settings);
+        for (std::size_t i = 0; i < count; ++i) {
+            dest[i] = table[static_cast<int>(source[i]) - offset];
+        }
+    } else {
+        Q_UNUSED(table);
+        Q_UNUSED(offset);
+        const VoiEvaluator voi(settings);
+        for (std::size_t i = 0; i < count; ++i) {
+            dest[i] = voi(static_cast<double>(source[i]));
+        }
+    }
+}
+
+} // namespace
+
+void WindowLevelLut::update(const VoiSettings& settings, int scalarType)
+{
+    if (scalarType == m_scalarType && settings == m_settings) return;
+
+    m_settings = settings;
+    m_scalarType = scalarType;
+
+    switch (scalarType) {
+        vtkTemplateMacro(fillTable<VTK_TT>(m_settings, m_table, m_offset));
+    default:
+        m_table.clear();
+        break;
+    }
+}
+
+void WindowLevelLut::mapValues(const void* source, std::size_t count, unsigned char* dest) const
+{
+    switch (m_scalarType) {
+        vtkTemplateMacro(mapTyped(static_cast<const VTK_TT*>(source), count, m_settings,
+                                  m_table.data(), m_offset, dest));
+    default:
+        break;
+    }
+}
+
+void WindowLevelLut::mapRegion(vtkImageData* source, int slice, const int region[4],
+                               vtkImageData* display, QThreadPool* pool) const
+{
+    if (!source || !display || source->GetScalarType() != m_scalarType) return;
+
+    int dims[3];
+    source->GetDimensions(dims);
+    const int components = source->GetNumberOfScalarComponents();
+    const int x0 = std::max(region[0], 0);
+    const int x1 = std::min(region[1], dims[0] - 1);
+    const int y0 = std::max(region[2], 0);
+    const int y1 = std::min(region[3], dims[1] - 1);
+    if (x0 > x1 || y0 > y1 || slice < 0 || slice >= dims[2]) return;
+
+    // Row addressing is done here once: workers only touch raw pointers
+    const std::size_t scalarSize = source->GetScalarSize();
+    const std::size_t rowValues = static_cast<std::size_t>(dims[0]) * components;
+    const std::size_t count = static_cast<std::size_t>(x1 - x0 + 1) * components;
+    const char* sourceBase = static_cast<const char*>(source->GetScalarPointer(0, 0, slice))
+                             + static_cast<std::size_t>(x0) * components * scalarSize;
+    unsigned char* displayBase = static_cast<unsigned char*>(display->GetScalarPointer(0, 0, 0))
+                                 + static_cast<std::size_t>(x0) * components;
+
+    parallelFor(pool, y0, y1 + 1, 32, [&](int first, int last) {
+        for (int y = first; y < last; ++y) {
+            mapValues(sourceBase + y * rowValues * scalarSize, count, displayBase + y * rowValues);
+        }
+    });
+}
+
+QImage renderSlice(vtkImageData* image, int slice, const WindowLevelLut& lut)
+{
+    if (!image || image->GetScalarType() != lut.scalarType()) return QImage();
+
+    int dims[3];
+    image->GetDimensions(dims);
+    const int components = image->GetNumberOfScalarComponents();
+    if (slice < 0 || slice >= dims[2] || (components != 1 && components != 3)) {
+        return QImage();
+    }
+
+    QImage output(dims[0], dims[1], components == 3 ? QImage::Format_RGB888 : QImage::Format_Grayscale8);
+    const char* slicePtr = static_cast<const char*>(image->GetScalarPointer(0, 0, slice));
+    const std::size_t rowValues = static_cast<std::size_t>(dims[0]) * components;
+    const std::size_t rowBytes = rowValues * image->GetScalarSize();
+
+    for (int y = 0; y < dims[1]; ++y) {
+        // vtkImageData is bottom-up, QImage is top-down
+        lut.mapValues(slicePtr + static_cast<std::size_t>(dims[1] - 1 - y) * rowBytes, rowValues, output.scanLine(y));
+    }
+
+    return output;
+}
+
+} // namespace imaging
@@ -0,0 +1,53 @@
+#ifndef WINDOWLEVELLUT_H
+#define WINDOWLEVELLUT_H
+
+#include "WindowLevel.h"
+
+#include <QImage>
+
+#include <cstddef>
+#include <vector>
+
+class QThreadPool;
+class vtkImageData;
+
+namespace imaging {
+
+// Stored value -> display byte table for one VoiSettings. 8- and 16-bit
+// integer data index a 256- or 64K-entry table that stays cache resident,
+// so a W/L change costs one table rebuild plus one load per visible pixel
+// instead of per-pixel floating point. Other scalar types evaluate the VOI
+// stage per pixel.
+class WindowLevelLut
+{
+public:
+    // Rebuilds only when the settings or the scalar type changed
+    void update(const VoiSettings& settings, int scalarType);
+
+    const VoiSettings& settings() const { return m_settings; }
+    int scalarType() const { return m_scalarType; }
+
+    // Maps `count` values of the table's scalar type
+    void mapValues(const void* source, std::size_t count, unsigned char* dest) const;
+
+    // Maps the inclusive rectangle region = {x0, x1, y0, y1} of `slice` into
+    // the same pixels of `display` (unsigned char, one slice, same width,
+    // height and components). Bands of rows run in parallel on `pool`.
+    void mapRegion(vtkImageData* source, int slice, const int region[4],
+                   vtkImageData* display, QThreadPool* pool) const;
+
+private:
+    VoiSettings m_settings;
+    int m_scalarType = -1;
+    int m_offset = 0; // table index = value - m_offset
+    std::vector<unsigned char> m_table;
+};
+
+// Renders one slice of a 1- or 3-component image to a top-down QImage
+// (Grayscale8 or RGB888) with the same mapping as the viewer. Returns a
+// null image for unsupported layouts.
+QImage renderSlice(vtkImageData* image, int slice, const WindowLevelLut& lut);
+
+} // namespace imaging
+
+#endif // WINDOWLEVELLUT_H
@@ -0,0 +1,46 @@
+#ifndef DICOMMETADATA_H
+#define DICOMMETADATA_H
+
+#include <QString>
+#include <QVector>
+
+namespace models {
+
+struct DicomMetadata {
+    QString patientName;
+    QString patientId;
+    QString studyDate;
+    QString modality;
+    QString institutionName;
+    QString studyInstanceUid;
+    QString seriesInstanceUid;
+    QString sopInstanceUid;
+    int instanceNumber = 0;
+    int rows = 0;
+    int columns = 0;
+    int bitsAllocated = 0;
+    int bitsStored = 0;
+    int pixelRepresentation = 0;
+    int samplesPerPixel = 1;
+    double windowCenter = 0.0;
+    double windowWidth = 0.0;
+    double pixelSpacingX = 1.0;
+    double pixelSpacingY = 1.0;
+    double sliceSpacing = 1.0;
+    double rescaleSlope = 1.0;
+    double rescaleIntercept = 0.0;
+    // Integer rescale already applied to the decoded pixels (slope/intercept
+    // above are then identity)
+    bool rescaleApplied = false;
+
+    // VOI stage from the dataset: VOI LUT Function (LINEAR, LINEAR_EXACT,
+    // SIGMOID) and the first item of the VOI LUT Sequence, if present
+    QString voiLutFunction;
+    QVector<quint16> voiLutData;
+    int voiLutFirstMapped = 0;
+    int voiLutBits = 16;
+};
+
+} // namespace models
+
+#endif // DICOMMETADATA_H
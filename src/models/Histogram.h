@@ -0,0 +1,33 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <QVector>
+
+namespace models {
+
+// Voxel value histogram, used for automatic window/level and kept in the
+// fast-open cache so it is never recomputed. [minValue, maxValue] is the
+// measured range of the data and the bins split it evenly: value v falls
+// into bin int((v - minValue) * bins.size() / (maxValue - minValue)), the
+// maximum into the last bin (everything into bin 0 for a constant image).
+struct Histogram {
+    double minValue = 0.0;
+    double maxValue = 0.0;
+    QVector<quint32> bins;
+
+    bool isEmpty() const { return bins.isEmpty(); }
+};
+
+// Exact pixel count per integer value over [firstValue, firstValue +
+// counts.size()), as the unpack pass produces it per frame. Unlike binned
+// histograms these add up across frames whose ranges differ.
+struct ValueCounts {
+    int firstValue = 0;
+    QVector<quint32> counts;
+
+    bool isEmpty() const { return counts.isEmpty(); }
+};
+
+} // namespace models
+
+#endif // HISTOGRAM_H
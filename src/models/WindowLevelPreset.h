@@ -0,0 +1,35 @@
+#ifndef WINDOWLEVELPRESET_H
+#define WINDOWLEVELPRESET_H
+
+#include <QString>
+#include <QVector>
+
+namespace models {
+
+struct WindowLevelPreset {
+    QString name;
+    double window = 0.0;
+    double level = 0.0;
+
+    // A preset without width means "use the window stored in the dataset"
+    bool usesDatasetWindow() const { return window == 0.0; }
+};
+
+inline QVector<WindowLevelPreset> defaultPresets(const QString& modality)
+{
+    QVector<WindowLevelPreset> presets;
+    presets.append({QStringLiteral("dicom"), 0.0, 0.0});
+
+    if (modality == QLatin1String("CT")) {
+        presets.append({QStringLiteral("pulmao"), 1500.0, -600.0});
+        presets.append({QStringLiteral("mediastino"), 350.0, 50.0});
+        presets.append({QStringLiteral("osso"), 2000.0, 300.0});
+        presets.append({QStringLiteral("cerebro"), 80.0, 40.0});
+    }
+
+    return presets;
+}
+
+} // namespace models
+
+#endif // WINDOWLEVELPRESET_H
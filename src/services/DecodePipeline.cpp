@@ -0,0 +1,86 @@
+#include "DecodePipeline.h"
+
+#include <QThreadPool>
+
+#include <dcmtk/dcmdata/dcdatset.h>
+
+namespace services {
+
+DecodePipeline::DecodePipeline(ImageCache& cache, QThreadPool* pool, QObject* parent)
+    : QObject(parent)
+    , m_cache(cache)
+    , m_pool(pool)
+{
+    qRegisterMetaType<services::DecodedImagePtr>();
+}
+
+DecodePipeline::~DecodePipeline()
+{
+    waitForDone();
+}
+
+void DecodePipeline::submit(DcmDataset* dataset, const QString& origin)
+{
+    if (!dataset) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        ++m_pending;
+        ++m_inFlight;
+    }
+    m_pool->start([this, dataset, origin]() {
+        std::unique_ptr<DcmDataset> owned(dataset);
+        publish(DicomDecoder::decodeDataset(owned.get()), origin);
+    });
+}
+
+void DecodePipeline::submitFile(const QString& filePath)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        ++m_pending;
+        ++m_inFlight;
+    }
+    m_pool->start([this, filePath]() {
+        publish(DicomDecoder::decodeFile(filePath), filePath);
+    });
+}
+
+int DecodePipeline::pendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    return m_pending;
+}
+
+void DecodePipeline::waitForDone()
+{
+    std::unique_lock<std::mutex> lock(m_pendingMutex);
+    m_idle.wait(lock, [this]() { return m_inFlight == 0; });
+}
+
+void DecodePipeline::publish(const DecodedImagePtr& image, const QString& origin)
+{
+    if (image) {
+        m_cache.insert(image);
+    }
+
+    // Decrement before emitting, so queued receivers see a settled count.
+    // The task stays in flight until its signal is out, which keeps
+    // waitForDone() (and the destructor) from racing the emit.
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        --m_pending;
+    }
+
+    if (image) {
+        emit imageDecoded(image);
+    } else {
+        emit decodeFailed(origin);
+    }
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    --m_inFlight;
+    m_idle.notify_all();
+}
+
+} // namespace services
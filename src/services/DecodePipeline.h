@@ -0,0 +1,58 @@
+#ifndef DECODEPIPELINE_H
+#define DECODEPIPELINE_H
+
+#include <QObject>
+#include <QString>
+
+#include <condition_variable>
+#include <mutex>
+
+#include "DicomDecoder.h"
+#include "ImageCache.h"
+
+class DcmDataset;
+class QThreadPool;
+
+namespace services {
+
+// Decodes instances on a worker pool and publishes them to the cache as
+// soon as each one is ready, so consumers can display the first images
+// while the rest of the series is still arriving.
+class DecodePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    DecodePipeline(ImageCache& cache, QThreadPool* pool, QObject* parent = nullptr);
+    ~DecodePipeline() override;
+
+    // Takes ownership of the dataset. Safe to call from any thread.
+    void submit(DcmDataset* dataset, const QString& origin = QString());
+    void submitFile(const QString& filePath);
+
+    int pendingCount() const;
+    void waitForDone();
+
+    ImageCache& cache() { return m_cache; }
+    QThreadPool* threadPool() const { return m_pool; }
+
+signals:
+    void imageDecoded(const services::DecodedImagePtr& image);
+    void decodeFailed(const QString& origin);
+
+private:
+    void publish(const DecodedImagePtr& image, const QString& origin);
+
+    ImageCache& m_cache;
+    QThreadPool* m_pool;
+
+    // The pool is shared, so completion is tracked per pipeline
+    mutable std::mutex m_pendingMutex;
+    std::condition_variable m_idle;
+    int m_pending = 0;
+    int m_inFlight = 0;
+};
+
+} // namespace services
+
+#endif // DECODEPIPELINE_H
@@ -0,0 +1,350 @@
+#include "DicomDecoder.h"
+#include "ImagingCore.h"
+#include "imaging/Histogram.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcxfer.h>
+#include <dcmtk/dcmimgle/dcmimage.h>
+
+namespace services {
+
+// --- Helper DRY Template ---
+template<typename T>
+void DicomDecoder::copyPixelData(void* dest, const T* source, size_t rows, size_t cols, size_t samplesPerPixel) {
+    T* vtkData = static_cast<T*>(dest);
+    const size_t rowBytes = cols * samplesPerPixel * sizeof(T);
+
+    // Flip Y axis (DICOM Top-Left -> VTK Bottom-Left)
+    for (size_t y = 0; y < rows; ++y) {
+        const size_t srcRow = rows - 1 - y;
+        memcpy(vtkData + y * cols * samplesPerPixel,
+               source + srcRow * cols * samplesPerPixel,
+               rowBytes);
+    }
+}
+
+// --- SRP: Metadata Extraction ---
+bool DicomDecoder::extractMetadata(DcmDataset* dataset, models::DicomMetadata& metadata) {
+    if (!dataset) return false;
+
+    Uint16 rows = 0, cols = 0;
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, cols);
+
+    if (rows == 0 || cols == 0) return false;
+
+    Uint16 bitsAllocated = 16, bitsStored = 12, highBit = 11;
+    Uint16 pixelRepresentation = 0;
+    Uint16 samplesPerPixel = 1;
+
+    dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    dataset->findAndGetUint16(DCM_BitsStored, bitsStored);
+    dataset->findAndGetUint16(DCM_HighBit, highBit);
+    dataset->findAndGetUint16(DCM_PixelRepresentation, pixelRepresentation);
+    dataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel);
+
+    metadata.rows = rows;
+    metadata.columns = cols;
+    metadata.bitsAllocated = bitsAllocated;
+    metadata.bitsStored = bitsStored;
+    metadata.pixelRepresentation = pixelRepresentation;
+    metadata.samplesPerPixel = samplesPerPixel;
+
+    OFString strValue;
+    if (dataset->findAndGetOFString(DCM_PatientName, strValue).good()) {
+        metadata.patientName = QString::fromUtf8(strValue.c_str());
+    }
+    if (dataset->findAndGetOFString(DCM_PatientID, strValue).good()) {
+        metadata.patientId = QString::fromUtf8(strValue.c_str());
+    }
+    if (dataset->findAndGetOFString(DCM_StudyDate, strValue).good()) {
+        metadata.studyDate = QString::fromUtf8(strValue.c_str());
+    }
+    if (dataset->findAndGetOFString(DCM_Modality, strValue).good()) {
+        metadata.modality = QString::fromUtf8(strValue.c_str());
+    }
+    if (dataset->findAndGetOFString(DCM_InstitutionName, strValue).good()) {
+        metadata.institutionName = QString::fromUtf8(strValue.c_str());
+    }
+    if (dataset->findAndGetOFString(DCM_StudyInstanceUID, strValue).good()) {
+        metadata.studyInstanceUid = QString::fromLatin1(strValue.c_str());
+    }
+    if (dataset->findAndGetOFString(DCM_SeriesInstanceUID, strValue).good()) {
+        metadata.seriesInstanceUid = QString::fromLatin1(strValue.c_str());
+    }
+    if (dataset->findAndGetOFString(DCM_SOPInstanceUID, strValue).good()) {
+        metadata.sopInstanceUid = QString::fromLatin1(strValue.c_str());
+    }
+
+    Sint32 instanceNumber = 0;
+    if (dataset->findAndGetSint32(DCM_InstanceNumber, instanceNumber).good()) {
+        metadata.instanceNumber = instanceNumber;
+    }
+
+    Float64 windowCenter = 0.0, windowWidth = 0.0;
+    if (dataset->findAndGetFloat64(DCM_WindowCenter, windowCenter).good() &&
+        dataset->findAndGetFloat64(DCM_WindowWidth, windowWidth).good()) {
+        metadata.windowCenter = windowCenter;
+        metadata.windowWidth = windowWidth;
+    }
+
+    OFString pixelSpacing;
+    if (dataset->findAndGetOFString(DCM_PixelSpacing, pixelSpacing, 0).good()) {
+        metadata.pixelSpacingY = QString::fromStdString(pixelSpacing.c_str()).toDouble();
+    }
+    if (dataset->findAndGetOFString(DCM_PixelSpacing, pixelSpacing, 1).good()) {
+        metadata.pixelSpacingX = QString::fromStdString(pixelSpacing.c_str()).toDouble();
+    }
+
+    Float64 sliceSpacing = 0.0;
+    if ((dataset->findAndGetFloat64(DCM_SpacingBetweenSlices, sliceSpacing).good() ||
+         dataset->findAndGetFloat64(DCM_SliceThickness, sliceSpacing).good()) && sliceSpacing > 0.0) {
+        metadata.sliceSpacing = sliceSpacing;
+    }
+
+    Float64 rescaleSlope = 1.0, rescaleIntercept = 0.0;
+    dataset->findAndGetFloat64(DCM_RescaleSlope, rescaleSlope);
+    dataset->findAndGetFloat64(DCM_RescaleIntercept, rescaleIntercept);
+    metadata.rescaleSlope = rescaleSlope;
+    metadata.rescaleIntercept = rescaleIntercept;
+
+    if (dataset->findAndGetOFString(DCM_VOILUTFunction, strValue).good()) {
+        metadata.voiLutFunction = QString::fromLatin1(strValue.c_str()).trimmed().toUpper();
+    }
+    extractVoiLut(dataset, metadata);
+
+    return true;
+}
+
+// --- VOI LUT Sequence (first item only) ---
+void DicomDecoder::extractVoiLut(DcmDataset* dataset, models::DicomMetadata& metadata) {
+    DcmItem* item = nullptr;
+    if (dataset->findAndGetSequenceItem(DCM_VOILUTSequence, item, 0).bad() || !item) return;
+
+    // LUT Descriptor may be US or SS: entries (0 = 65536), first mapped, bits
+    long descriptor[3] = {0, 0, 0};
+    for (unsigned long i = 0; i < 3; ++i) {
+        Uint16 unsignedValue = 0;
+        Sint16 signedValue = 0;
+        if (item->findAndGetUint16(DCM_LUTDescriptor, unsignedValue, i).good()) {
+            // First mapped follows Pixel Representation even when encoded as US
+            descriptor[i] = (i == 1 && metadata.pixelRepresentation == 1)
+                ? static_cast<Sint16>(unsignedValue) : unsignedValue;
+        } else if (item->findAndGetSint16(DCM_LUTDescriptor, signedValue, i).good()) {
+            descriptor[i] = signedValue;
+        } else {
+            return;
+        }
+    }
+
+    const unsigned long entries = descriptor[0] == 0 ? 65536 : static_cast<unsigned long>(descriptor[0]);
+    const int bits = static_cast<int>(descriptor[2]);
+    if (bits < 1 || bits > 16) return;
+
+    const Uint16* data = nullptr;
+    unsigned long count = 0;
+    if (item->findAndGetUint16Array(DCM_LUTData, data, &count).bad() || !data || count == 0) return;
+
+    QVector<quint16> lut(static_cast<int>(entries));
+    if (bits <= 8 && count * 2 >= entries && count < entries) {
+        // 8-bit entries packed two per OW word (little endian)
+        for (unsigned long i = 0; i < entries; ++i) {
+            lut[i] = (i % 2 == 0) ? (data[i / 2] & 0xff) : (data[i / 2] >> 8);
+        }
+    } else if (count >= entries) {
+        std::copy(data, data + entries, lut.begin());
+    } else {
+        return;
+    }
+
+    metadata.voiLutData = lut;
+    metadata.voiLutFirstMapped = static_cast<int>(descriptor[1]);
+    metadata.voiLutBits = bits;
+}
+
+// --- Pixel format descriptor (PS3.3 C.7.6.3) ---
+imaging::PixelFormat DicomDecoder::pixelFormat(DcmDataset* dataset, const models::DicomMetadata& metadata) {
+    imaging::PixelFormat format;
+    format.bitsAllocated = metadata.bitsAllocated;
+    format.bitsStored = metadata.bitsStored;
+    format.highBit = metadata.bitsStored - 1;
+    format.isSigned = metadata.pixelRepresentation == 1;
+    format.samplesPerPixel = metadata.samplesPerPixel;
+    // DCMTK hands out pixel data in host byte order
+    format.bigEndian = Q_BYTE_ORDER == Q_BIG_ENDIAN;
+
+    Uint16 value = 0;
+    if (dataset->findAndGetUint16(DCM_HighBit, value).good()) {
+        format.highBit = value;
+    }
+    if (dataset->findAndGetUint16(DCM_PlanarConfiguration, value).good()) {
+        format.planarConfiguration = value;
+    }
+
+    OFString photometric;
+    if (dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric).good()) {
+        format.photometric = imaging::PixelFormat::photometricFromString(QString::fromLatin1(photometric.c_str()));
+    } else if (metadata.samplesPerPixel == 1) {
+        format.photometric = imaging::Photometric::Monochrome2;
+    }
+
+    return format;
+}
+
+// --- SRP: Image Creation ---
+vtkSmartPointer<vtkImageData> DicomDecoder::createVtkImage(DcmDataset* dataset, models::DicomMetadata& metadata,
+                                                           models::ValueCounts& valueCounts) {
+    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+    imageData->SetDimensions(metadata.columns, metadata.rows, 1);
+    imageData->SetSpacing(metadata.pixelSpacingX, metadata.pixelSpacingY, 1.0);
+    imageData->SetOrigin(0.0, 0.0, 0.0);
+
+    const imaging::PixelFormat format = pixelFormat(dataset, metadata);
+
+    // Monochrome layouts without a kernel (e.g. 32-bit) cannot be displayed
+    if (!format.isSupported() && format.isMonochrome()) {
+        qWarning() << "DCMTK: Unsupported monochrome pixel format, bits allocated" << metadata.bitsAllocated;
+        return nullptr;
+    }
+
+    // Palette color, YBR_422 and other exotic color layouts: let DicomImage
+    // render them to 8-bit RGB
+    if (!format.isSupported()) {
+        DicomImage dcmImage(dataset, dataset->getOriginalXfer());
+        if (dcmImage.getStatus() != EIS_Normal || dcmImage.isMonochrome()) {
+            qWarning() << "DCMTK: Error processing color image";
+            return nullptr;
+        }
+
+        const unsigned long required = static_cast<unsigned long>(metadata.rows) * metadata.columns * 3;
+        if (dcmImage.getOutputDataSize(8) < required) return nullptr;
+
+        imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
+        const void* rawData = dcmImage.getOutputData(8); // Renders internal buffer
+
+        copyPixelData(imageData->GetScalarPointer(),
+                      static_cast<const unsigned char*>(rawData),
+                      metadata.rows, metadata.columns, 3);
+
+        // Palette color has one stored sample but decodes to RGB; consumers
+        // (VOI, export) go by the decoded layout
+        metadata.samplesPerPixel = 3;
+
+        if (metadata.windowWidth == 0.0) {
+            metadata.windowWidth = 255.0;
+            metadata.windowCenter = 127.5;
+        }
+        return imageData;
+    }
+
+    const void* pixels = nullptr;
+    unsigned long available = 0;
+    if (format.bitsAllocated == 8) {
+        const Uint8* pixelData8 = nullptr;
+        if (dataset->findAndGetUint8Array(DCM_PixelData, pixelData8, &available).bad()) return nullptr;
+        pixels = pixelData8;
+    } else {
+        const Uint16* pixelData16 = nullptr;
+        if (dataset->findAndGetUint16Array(DCM_PixelData, pixelData16, &available).bad()) return nullptr;
+        pixels = pixelData16;
+    }
+
+    const unsigned long required = static_cast<unsigned long>(metadata.rows) * metadata.columns
+                                   * metadata.samplesPerPixel;
+    if (!pixels || available < required) {
+        qWarning() << "DCMTK: Pixel Data shorter than the image geometry";
+        return nullptr;
+    }
+
+    // Integer rescale (CT HU) is folded into the unpack pass; the stored
+    // slope/intercept then become identity for every consumer downstream
+    const bool rescale = imaging::canRescaleToInt16(format, metadata.rescaleSlope, metadata.rescaleIntercept);
+    const int intercept = rescale ? static_cast<int>(metadata.rescaleIntercept) : 0;
+
+    imageData->AllocateScalars(imaging::outputScalarType(format, rescale), format.isMonochrome() ? 1 : 3);
+
+    imaging::UnpackResult unpacked;
+    if (!imaging::unpackPixels(format, pixels, metadata.rows, metadata.columns, rescale, intercept,
+                               imageData->GetScalarPointer(), unpacked)) {
+        return nullptr;
+    }
+    valueCounts = unpacked.counts;
+
+    if (rescale) {
+        metadata.rescaleSlope = 1.0;
+        metadata.rescaleIntercept = 0.0;
+        metadata.rescaleApplied = true;
+    }
+
+    if (!format.isMonochrome()) {
+        if (metadata.windowWidth == 0.0) {
+            metadata.windowWidth = 255.0;
+            metadata.windowCenter = 127.5;
+        }
+        return imageData;
+    }
+
+    // Auto Window/Level if missing (in modality units, like the dataset's),
+    // from the range the unpack pass already measured
+    if (metadata.windowWidth == 0.0) {
+        const double minValue = unpacked.minValue;
+        const double maxValue = unpacked.maxValue;
+        metadata.windowWidth = (maxValue - minValue) * std::abs(metadata.rescaleSlope);
+        metadata.windowCenter = (minValue + (maxValue - minValue) / 2.0) * metadata.rescaleSlope
+                                + metadata.rescaleIntercept;
+    }
+
+    return imageData;
+}
+
+DecodedImagePtr DicomDecoder::decodeFile(const QString& filePath)
+{
+    DcmFileFormat fileFormat;
+    OFCondition status = fileFormat.loadFile(filePath.toStdString().c_str());
+
+    if (status.bad()) {
+        qWarning() << "DCMTK: Failed to load file:" << filePath << "-" << status.text();
+        return nullptr;
+    }
+
+    return decodeDataset(fileFormat.getDataset(), filePath);
+}
+
+DecodedImagePtr DicomDecoder::decodeDataset(DcmDataset* dataset, const QString& sourcePath)
+{
+    if (!dataset) {
+        qWarning() << "DCMTK: Invalid dataset";
+        return nullptr;
+    }
+
+    // Codecs are registered lazily: only compressed datasets wait for them
+    if (DcmXfer(dataset->getOriginalXfer()).isEncapsulated()) {
+        ImagingCore::ensureCodecs();
+    }
+    dataset->chooseRepresentation(EXS_LittleEndianExplicit, nullptr);
+
+    auto decoded = std::make_shared<DecodedImage>();
+    decoded->sourcePath = sourcePath;
+
+    if (!extractMetadata(dataset, decoded->metadata)) {
+        qWarning() << "DCMTK: Failed to extract metadata or invalid dimensions";
+        return nullptr;
+    }
+
+    decoded->image = createVtkImage(dataset, decoded->metadata, decoded->valueCounts);
+    if (!decoded->image || decoded->image->GetNumberOfPoints() == 0) {
+        return nullptr;
+    }
+    decoded->histogram = imaging::binValueCounts(decoded->valueCounts);
+
+    return decoded;
+}
+
+} // namespace services
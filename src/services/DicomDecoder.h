@@ -0,0 +1,54 @@
+#ifndef DICOMDECODER_H
+#define DICOMDECODER_H
+
+#include <QMetaType>
+#include <QString>
+
+#include <memory>
+
+#include <vtkSmartPointer.h>
+#include <vtkImageData.h>
+
+#include "imaging/PixelFormat.h"
+#include "models/DicomMetadata.h"
+#include "models/Histogram.h"
+
+class DcmDataset;
+
+namespace services {
+
+// Immutable decode result, safe to share between threads.
+struct DecodedImage {
+    models::DicomMetadata metadata;
+    vtkSmartPointer<vtkImageData> image;
+    QString sourcePath;
+    models::Histogram histogram;
+    models::ValueCounts valueCounts; // per frame from the unpack pass, merged into a series histogram
+};
+
+using DecodedImagePtr = std::shared_ptr<const DecodedImage>;
+
+// Converts DICOM datasets into vtkImageData. Stateless and thread-safe:
+// every call works on its own dataset.
+class DicomDecoder
+{
+public:
+    static DecodedImagePtr decodeFile(const QString& filePath);
+    static DecodedImagePtr decodeDataset(DcmDataset* dataset, const QString& sourcePath = QString());
+
+private:
+    static bool extractMetadata(DcmDataset* dataset, models::DicomMetadata& metadata);
+    static void extractVoiLut(DcmDataset* dataset, models::DicomMetadata& metadata);
+    static imaging::PixelFormat pixelFormat(DcmDataset* dataset, const models::DicomMetadata& metadata);
+    static vtkSmartPointer<vtkImageData> createVtkImage(DcmDataset* dataset, models::DicomMetadata& metadata,
+                                                        models::ValueCounts& valueCounts);
+
+    template<typename T>
+    static void copyPixelData(void* dest, const T* source, size_t rows, size_t cols, size_t samplesPerPixel);
+};
+
+} // namespace services
+
+Q_DECLARE_METATYPE(services::DecodedImagePtr)
+
+#endif // DICOMDECODER_H
@@ -0,0 +1,145 @@
+#include "ExportEngine.h"
+
+#include "imaging/ParallelFor.h"
+#include "imaging/WindowLevelLut.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include <vector>
+
+namespace services {
+
+ExportEngine::ExportEngine(QThreadPool* pool, QObject* parent)
+    : QObject(parent)
+    , m_pool(pool)
+{
+    qRegisterMetaType<services::ExportStats>();
+    m_driverPool.setMaxThreadCount(1);
+}
+
+ExportEngine::~ExportEngine()
+{
+    m_driverPool.waitForDone();
+}
+
+int ExportEngine::exportImage(const DecodedImage& image, const ExportJob& job, QVector<int>& presetFailures)
+{
+    const models::DicomMetadata& metadata = image.metadata;
+
+    QString baseName = image.sourcePath.isEmpty() ? metadata.sopInstanceUid
+                                                  : QFileInfo(image.sourcePath).completeBaseName();
+    if (baseName.isEmpty()) {
+        baseName = QString::number(metadata.instanceNumber);
+    }
+
+    int dims[3];
+    image.image->GetDimensions(dims);
+
+    // One table per preset, shared by every slice of the instance
+    std::vector<imaging::WindowLevelLut> luts(job.presets.size());
+    for (int p = 0; p < job.presets.size(); ++p) {
+        const models::WindowLevelPreset& preset = job.presets[p];
+        const double window = preset.usesDatasetWindow() ? metadata.windowWidth : preset.window;
+        const double level = preset.usesDatasetWindow() ? metadata.windowCenter : preset.level;
+        luts[p].update(imaging::VoiSettings::fromMetadata(metadata, window, level, preset.usesDatasetWindow()),
+                       image.image->GetScalarType());
+    }
+
+    int written = 0;
+    for (int z = 0; z < dims[2]; ++z) {
+        const QString sliceName = dims[2] > 1 ? QString("%1_%2").arg(baseName).arg(z, 4, 10, QChar('0'))
+                                              : baseName;
+
+        for (int p = 0; p < job.presets.size(); ++p) {
+            const QImage rendered = imaging::renderSlice(image.image, z, luts[p]);
+            const QString path = QDir(job.outputDir).filePath(
+                QString("%1_%2.%3").arg(sliceName, job.presets[p].name, job.format));
+
+            // One bad file (disk full, unsupported format option) does not
+            // discard what was already written for this instance
+            if (rendered.isNull() || !rendered.save(path, job.format.toLatin1().constData(), job.quality)) {
+                qWarning().noquote() << QString("Export: failed to write %1 (preset %2)").arg(path, job.presets[p].name);
+                ++presetFailures[p];
+                continue;
+            }
+            ++written;
+        }
+    }
+    return written;
+}
+
+ExportStats ExportEngine::run(const ExportJob& job)
+{
+    ExportStats stats;
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!QDir().mkpath(job.outputDir) || job.presets.isEmpty()) {
+        stats.failures = job.files.size() + job.images.size();
+        return stats;
+    }
+
+    const int total = job.files.size() + job.images.size();
+    std::atomic<int> written{0};
+    std::atomic<int> decodeFailures{0};
+    std::atomic<int> done{0};
+    std::vector<std::atomic<int>> presetFailures(job.presets.size());
+
+    auto exportOne = [&](const DecodedImagePtr& image) {
+        if (image) {
+            QVector<int> failed(job.presets.size(), 0);
+            written += exportImage(*image, job, failed);
+            for (int p = 0; p < failed.size(); ++p) {
+                presetFailures[p] += failed[p];
+            }
+        } else {
+            ++decodeFailures;
+        }
+        emit progress(++done, total);
+    };
+
+    // One task per instance: decode (if needed) + every preset, so the
+    // source pixels are read from cache-hot memory for all presets
+    imaging::parallelFor(m_pool, 0, total, 1, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            exportOne(i < job.files.size() ? DicomDecoder::decodeFile(job.files[i])
+                                           : job.images[i - job.files.size()]);
+        }
+    });
+
+    stats.imagesWritten = written.load();
+    stats.failures = decodeFailures.load();
+    for (int p = 0; p < job.presets.size(); ++p) {
+        if (presetFailures[p] > 0) {
+            stats.failures += presetFailures[p];
+            stats.failedPresets << job.presets[p].name;
+        }
+    }
+    stats.elapsedMs = timer.elapsed();
+
+    qInfo().noquote() << QString("Export: %1 images in %2 ms (%3 images/s, %4 threads), %5 failures")
+                             .arg(stats.imagesWritten)
+                             .arg(stats.elapsedMs)
+                             .arg(stats.imagesPerSecond(), 0, 'f', 1)
+                             .arg(m_pool ? m_pool->maxThreadCount() : 1)
+                             .arg(stats.failures);
+    return stats;
+}
+
+void ExportEngine::start(const ExportJob& job)
+{
+    bool expected = false;
+    if (!m_busy.compare_exchange_strong(expected, true)) return;
+
+    // Keeps the GUI thread free; the driver also works through chunks itself
+    m_driverPool.start([this, job]() {
+        const ExportStats stats = run(job);
+        m_busy = false;
+        emit finished(stats);
+    });
+}
+
+} // namespace services
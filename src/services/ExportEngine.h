@@ -0,0 +1,75 @@
+#ifndef EXPORTENGINE_H
+#define EXPORTENGINE_H
+
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#include <atomic>
+
+#include "DicomDecoder.h"
+#include "models/WindowLevelPreset.h"
+
+namespace services {
+
+struct ExportJob {
+    QStringList files;                 // decoded on the workers
+    QVector<DecodedImagePtr> images;   // already decoded (e.g. from the cache)
+    QVector<models::WindowLevelPreset> presets;
+    QString outputDir;
+    QString format = QStringLiteral("png");
+    int quality = -1;
+};
+
+struct ExportStats {
+    int imagesWritten = 0;
+    int failures = 0;             // output files not written, plus sources that did not decode
+    QStringList failedPresets;    // presets with at least one file not written
+    qint64 elapsedMs = 0;
+
+    double imagesPerSecond() const
+    {
+        return elapsedMs > 0 ? imagesWritten * 1000.0 / elapsedMs : 0.0;
+    }
+};
+
+// Bulk key-image/snapshot export without a display: every slice goes
+// through the CPU window/level path (identical to vtkImageViewer2's mapping)
+// and is encoded with QImage, one task per source instance.
+class ExportEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ExportEngine(QThreadPool* pool, QObject* parent = nullptr);
+    ~ExportEngine() override;
+
+    // Blocks until the job is done. Safe to call from a worker thread.
+    ExportStats run(const ExportJob& job);
+
+    // Runs the job in the background and emits finished().
+    void start(const ExportJob& job);
+    bool isBusy() const { return m_busy.load(); }
+
+signals:
+    void progress(int done, int total);
+    void finished(const services::ExportStats& stats);
+
+private:
+    // Writes every slice x preset it can; returns the files written and
+    // counts the failures per preset
+    int exportImage(const DecodedImage& image, const ExportJob& job, QVector<int>& presetFailures);
+
+    QThreadPool* m_pool;
+    QThreadPool m_driverPool;
+    std::atomic<bool> m_busy{false};
+};
+
+} // namespace services
+
+Q_DECLARE_METATYPE(services::ExportStats)
+
+#endif // EXPORTENGINE_H
@@ -0,0 +1,80 @@
+#include "ImageCache.h"
+
+#include <QMutexLocker>
+#include <QSet>
+
+#include <algorithm>
+
+namespace services {
+
+ImageCache::ImageCache(int maxCostKiB)
+{
+    m_cache.setMaxCost(maxCostKiB);
+}
+
+QString ImageCache::keyFor(const DecodedImage& image)
+{
+    return image.metadata.sopInstanceUid.isEmpty() ? image.sourcePath
+                                                   : image.metadata.sopInstanceUid;
+}
+
+void ImageCache::insert(const DecodedImagePtr& image)
+{
+    if (!image) return;
+    insert(keyFor(*image), image);
+}
+
+void ImageCache::insert(const QString& key, const DecodedImagePtr& image)
+{
+    if (!image || !image->image || key.isEmpty()) return;
+
+    const int cost = qMax(1, static_cast<int>(image->image->GetActualMemorySize()));
+
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(key, new DecodedImagePtr(image), cost);
+}
+
+DecodedImagePtr ImageCache::find(const QString& key) const
+{
+    QMutexLocker locker(&m_mutex);
+    const DecodedImagePtr* entry = m_cache.object(key);
+    return entry ? *entry : nullptr;
+}
+
+QVector<DecodedImagePtr> ImageCache::series(const QString& seriesInstanceUid) const
+{
+    QVector<DecodedImagePtr> result;
+    QSet<const DecodedImage*> seen;
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto keys = m_cache.keys();
+        for (const QString& key : keys) {
+            const DecodedImagePtr* entry = m_cache.object(key);
+            // Whole-series volumes are cached too; only single instances count here
+            if (entry && (*entry)->metadata.seriesInstanceUid == seriesInstanceUid &&
+                (*entry)->image->GetDimensions()[2] == 1 && !seen.contains(entry->get())) {
+                seen.insert(entry->get());
+                result.append(*entry);
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const DecodedImagePtr& a, const DecodedImagePtr& b) {
+        return a->metadata.instanceNumber < b->metadata.instanceNumber;
+    });
+    return result;
+}
+
+int ImageCache::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.count();
+}
+
+void ImageCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+} // namespace services
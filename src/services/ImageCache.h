@@ -0,0 +1,40 @@
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include "DicomDecoder.h"
+
+namespace services {
+
+// Thread-safe LRU cache of decoded instances, keyed by SOP Instance UID
+// (or by source path when the dataset has none). The cost of each entry is
+// the pixel memory in KiB, so the budget is a memory budget.
+class ImageCache
+{
+public:
+    explicit ImageCache(int maxCostKiB = 2 * 1024 * 1024);
+
+    void insert(const DecodedImagePtr& image);
+    void insert(const QString& key, const DecodedImagePtr& image);
+    DecodedImagePtr find(const QString& key) const;
+
+    // Cached instances of a series, ordered by Instance Number.
+    QVector<DecodedImagePtr> series(const QString& seriesInstanceUid) const;
+
+    int count() const;
+    void clear();
+
+    static QString keyFor(const DecodedImage& image);
+
+private:
+    mutable QMutex m_mutex;
+    mutable QCache<QString, DecodedImagePtr> m_cache;
+};
+
+} // namespace services
+
+#endif // IMAGECACHE_H
@@ -0,0 +1,192 @@
+#include "ImagingCore.h"
+#include "SeriesLoader.h"
+#include "VolumeCache.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <mutex>
+
+#include <dcmtk/dcmjpeg/djdecode.h>
+#include <dcmtk/dcmimage/diregist.h>
+
+namespace services {
+
+namespace {
+
+std::mutex g_coreMutex;
+std::weak_ptr<ImagingCore> g_core;
+
+// DCMTK's codec registry is global; the flag lets whoever gets there
+// first (the start-up task or a decoder) register, and the others wait.
+// Registration is counted per live core, not tied to g_core: a core
+// acquired while the previous one is still being destroyed keeps the
+// codecs, and only the last core to go cleans them up.
+std::mutex g_codecMutex;
+bool g_codecsRegistered = false;
+int g_codecUsers = 0;
+
+// Keys carry the same source fingerprint as the VolumeCache, so a file or
+// series rewritten on disk misses and the stale entry ages out of the LRU
+QString fileKey(const QString& filePath)
+{
+    const QString path = QFileInfo(filePath).absoluteFilePath();
+    return QStringLiteral("file:") + path + QLatin1Char('#')
+         + QString::fromLatin1(VolumeCache::fingerprint(QStringList(path)).toHex());
+}
+
+QString seriesKey(const QString& dirPath)
+{
+    const QString path = QDir(dirPath).absolutePath();
+    return QStringLiteral("series:") + path + QLatin1Char('#')
+         + QString::fromLatin1(VolumeCache::fingerprint(SeriesLoader::dicomFilesIn(path)).toHex());
+}
+
+} // namespace
+
+std::shared_ptr<ImagingCore> ImagingCore::acquire()
+{
+    std::lock_guard<std::mutex> lock(g_coreMutex);
+
+    std::shared_ptr<ImagingCore> core = g_core.lock();
+    if (!core) {
+        core.reset(new ImagingCore());
+        g_core = core;
+    }
+    return core;
+}
+
+ImagingCore::ImagingCore()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_codecMutex);
+        ++g_codecUsers;
+    }
+
+    m_pipeline = std::make_unique<DecodePipeline>(m_cache, &m_pool);
+
+    // Off the start-up path: the window does not wait for codec registration
+    m_pool.start(&ImagingCore::ensureCodecs);
+}
+
+ImagingCore::~ImagingCore()
+{
+    // Nothing may decode once the codecs are gone
+    m_pipeline.reset();
+    m_pool.waitForDone();
+
+    std::lock_guard<std::mutex> lock(g_codecMutex);
+    if (--g_codecUsers == 0 && g_codecsRegistered) {
+        DJDecoderRegistration::cleanup();
+        g_codecsRegistered = false;
+    }
+}
+
+void ImagingCore::ensureCodecs()
+{
+    std::lock_guard<std::mutex> lock(g_codecMutex);
+    if (!g_codecsRegistered) {
+        DJDecoderRegistration::registerCodecs();
+        g_codecsRegistered = true;
+    }
+}
+
+QString ImagingCore::normalizedPath(const QString& path)
+{
+    return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+}
+
+DecodedImagePtr ImagingCore::loadFile(const QString& filePath)
+{
+    const QString path = normalizedPath(filePath);
+    return load(fileKey(path), path, [path]() { return DicomDecoder::decodeFile(path); });
+}
+
+DecodedImagePtr ImagingCore::loadSeries(const QString& dirPath)
+{
+    const QString path = normalizedPath(dirPath);
+    return load(seriesKey(path), path, [this, path]() { return SeriesLoader::loadDirectory(path, &m_pool); });
+}
+
+void ImagingCore::prefetch(const QString& path)
+{
+    const QString target = normalizedPath(path);
+    const bool series = QFileInfo(target).isDir();
+    const QString key = series ? seriesKey(target) : fileKey(target);
+
+    PendingLoad pending;
+    LoadPromise promise;
+    if (DecodedImagePtr cached = findOrClaim(key, pending, promise)) {
+        QMetaObject::invokeMethod(this, [this, target, cached]() { emit loaded(target, cached); },
+                                  Qt::QueuedConnection);
+        return;
+    }
+    if (!promise) return; // already loading: its fulfil() emits loaded()
+
+    m_pool.start([this, key, target, promise, series]() {
+        fulfil(key, target, promise, [this, target, series]() {
+            return series ? SeriesLoader::loadDirectory(target, &m_pool) : DicomDecoder::decodeFile(target);
+        });
+    });
+}
+
+DecodedImagePtr ImagingCore::load(const QString& key, const QString& path,
+                                  const std::function<DecodedImagePtr()>& decode)
+{
+    PendingLoad pending;
+    LoadPromise promise;
+    if (DecodedImagePtr cached = findOrClaim(key, pending, promise)) {
+        return cached;
+    }
+    if (promise) {
+        fulfil(key, path, promise, decode);
+    }
+    return pending.get(); // rethrows what the decode threw
+}
+
+DecodedImagePtr ImagingCore::findOrClaim(const QString& key, PendingLoad& pending, LoadPromise& promise)
+{
+    // fulfil() caches the image before it drops the pending entry, so under
+    // this lock a finished load is always seen in one place or the other
+    std::lock_guard<std::mutex> lock(m_loadingMutex);
+
+    if (DecodedImagePtr cached = m_cache.find(key)) {
+        return cached;
+    }
+
+    const auto it = m_loading.constFind(key);
+    if (it != m_loading.constEnd()) {
+        pending = it.value();
+        return nullptr;
+    }
+
+    promise = std::make_shared<std::promise<DecodedImagePtr>>();
+    pending = promise->get_future().share();
+    m_loading.insert(key, pending);
+    return nullptr;
+}
+
+void ImagingCore::fulfil(const QString& key, const QString& path, const LoadPromise& promise,
+                         const std::function<DecodedImagePtr()>& decode)
+{
+    DecodedImagePtr image;
+    try {
+        image = decode();
+        if (image) {
+            m_cache.insert(key, image);
+        }
+        promise->set_value(image);
+    } catch (...) {
+        promise->set_exception(std::current_exception());
+    }
+
+    // Cached by now, so later loads no longer need the pending entry
+    {
+        std::lock_guard<std::mutex> lock(m_loadingMutex);
+        m_loading.remove(key);
+    }
+
+    emit loaded(path, image);
+}
+
+} // namespace services
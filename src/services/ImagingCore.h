@@ -0,0 +1,88 @@
+#ifndef IMAGINGCORE_H
+#define IMAGINGCORE_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+
+#include "DecodePipeline.h"
+#include "DicomDecoder.h"
+#include "ImageCache.h"
+
+namespace services {
+
+// Process-wide imaging state shared by every viewport: DCMTK codec
+// registration, the worker pool and the decoded-image cache. Reference
+// counted: the first acquire() starts registering the codecs on the pool,
+// the last owner to go away cleans them up, so viewports can come and go
+// freely.
+class ImagingCore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static std::shared_ptr<ImagingCore> acquire();
+    ~ImagingCore() override;
+
+    QThreadPool* threadPool() { return &m_pool; }
+    ImageCache& imageCache() { return m_cache; }
+    DecodePipeline& decodePipeline() { return *m_pipeline; }
+
+    // Cache-aware loads: viewports opening the same file or series get the
+    // same DecodedImage and therefore share pixel memory. A load already in
+    // flight (e.g. from prefetch()) is waited for, not decoded twice.
+    DecodedImagePtr loadFile(const QString& filePath);
+    DecodedImagePtr loadSeries(const QString& dirPath);
+
+    // Starts loading a file or series directory on the pool and returns
+    // immediately; used to decode command-line paths while the UI is built.
+    // loaded() follows for `path`, also when it was cached or already
+    // loading, so calling it again is the way to await a prefetch.
+    void prefetch(const QString& path);
+
+    // Absolute, cleaned form of a file or directory path, as reported by loaded()
+    static QString normalizedPath(const QString& path);
+
+    // Registers the DCMTK decompression codecs if that has not happened
+    // yet. Only compressed datasets need them, so decoders call this
+    // lazily; uncompressed files never wait for registration.
+    static void ensureCodecs();
+
+signals:
+    // A load finished (image is null if it failed). Emitted from the
+    // thread that did the work, usually a pool worker.
+    void loaded(const QString& path, const services::DecodedImagePtr& image);
+
+private:
+    ImagingCore();
+    ImagingCore(const ImagingCore&) = delete;
+    ImagingCore& operator=(const ImagingCore&) = delete;
+
+    using PendingLoad = std::shared_future<DecodedImagePtr>;
+    using LoadPromise = std::shared_ptr<std::promise<DecodedImagePtr>>;
+
+    DecodedImagePtr load(const QString& key, const QString& path, const std::function<DecodedImagePtr()>& decode);
+    // One atomic step: returns the cached image, or sets `pending` to the
+    // load in flight, or starts a new load the caller owns (`promise` and
+    // `pending` both set), so a key is never decoded twice at once
+    DecodedImagePtr findOrClaim(const QString& key, PendingLoad& pending, LoadPromise& promise);
+    void fulfil(const QString& key, const QString& path, const LoadPromise& promise,
+                const std::function<DecodedImagePtr()>& decode);
+
+    QThreadPool m_pool;
+    ImageCache m_cache;
+    std::unique_ptr<DecodePipeline> m_pipeline;
+
+    std::mutex m_loadingMutex;
+    QHash<QString, PendingLoad> m_loading;
+};
+
+} // namespace services
+
+#endif // IMAGINGCORE_H
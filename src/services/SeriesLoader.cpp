@@ -0,0 +1,139 @@
+#include "SeriesLoader.h"
+#include "VolumeCache.h"
+
+#include "imaging/Histogram.h"
+#include "imaging/ParallelFor.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstring>
+
+namespace services {
+
+QStringList SeriesLoader::dicomFilesIn(const QString& dirPath)
+{
+    QDir dir(dirPath);
+    QStringList filters;
+    filters << "*.dcm" << "*.DCM" << "*.dicom" << "*.DICOM";
+
+    QStringList files;
+    const QStringList names = dir.entryList(filters, QDir::Files, QDir::Name);
+    for (const QString& name : names) {
+        files << dir.absoluteFilePath(name);
+    }
+    return files;
+}
+
+DecodedImagePtr SeriesLoader::loadDirectory(const QString& dirPath, QThreadPool* pool)
+{
+    return loadFiles(dicomFilesIn(dirPath), pool);
+}
+
+DecodedImagePtr SeriesLoader::loadFiles(const QStringList& files, QThreadPool* pool)
+{
+    if (files.isEmpty()) return nullptr;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    VolumeCache& cache = VolumeCache::instance();
+    if (DecodedImagePtr cached = cache.open(files)) {
+        qInfo().noquote() << QString("Series: %1 slices from fast-open cache in %2 ms")
+                                 .arg(files.size()).arg(timer.elapsed());
+        return cached;
+    }
+
+    QVector<DecodedImagePtr> slices(files.size());
+    imaging::parallelFor(pool, 0, files.size(), 1, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            slices[i] = DicomDecoder::decodeFile(files[i]);
+        }
+    });
+
+    DecodedImagePtr volume = assemble(slices, pool);
+    if (!volume) return nullptr;
+
+    qInfo().noquote() << QString("Series: %1 slices decoded in %2 ms")
+                             .arg(files.size()).arg(timer.elapsed());
+
+    if (cache.isEnabled() && pool) {
+        pool->start([files, volume]() { VolumeCache::instance().store(files, *volume); });
+    }
+    return volume;
+}
+
+DecodedImagePtr SeriesLoader::assemble(QVector<DecodedImagePtr> slices, QThreadPool* pool)
+{
+    slices.erase(std::remove(slices.begin(), slices.end(), nullptr), slices.end());
+    if (slices.isEmpty()) return nullptr;
+
+    std::stable_sort(slices.begin(), slices.end(), [](const DecodedImagePtr& a, const DecodedImagePtr& b) {
+        return a->metadata.instanceNumber < b->metadata.instanceNumber;
+    });
+
+    // Every slice must share the geometry and pixel layout of the first one
+    vtkImageData* reference = slices.first()->image;
+    int refDims[3];
+    reference->GetDimensions(refDims);
+    const int scalarType = reference->GetScalarType();
+    const int components = reference->GetNumberOfScalarComponents();
+
+    const auto mismatched = std::remove_if(slices.begin() + 1, slices.end(), [&](const DecodedImagePtr& slice) {
+        int dims[3];
+        slice->image->GetDimensions(dims);
+        return dims[0] != refDims[0] || dims[1] != refDims[1] || dims[2] != 1 ||
+               slice->image->GetScalarType() != scalarType ||
+               slice->image->GetNumberOfScalarComponents() != components;
+    });
+    if (mismatched != slices.end()) {
+        qWarning() << "Series:" << std::distance(mismatched, slices.end())
+                   << "instances with a different geometry were skipped";
+        slices.erase(mismatched, slices.end());
+    }
+
+    auto volume = std::make_shared<DecodedImage>();
+    volume->metadata = slices.first()->metadata;
+    // Network instances have no file behind them
+    if (!slices.first()->sourcePath.isEmpty()) {
+        volume->sourcePath = QFileInfo(slices.first()->sourcePath).absolutePath();
+    }
+
+    const models::DicomMetadata& m = volume->metadata;
+    volume->image = vtkSmartPointer<vtkImageData>::New();
+    volume->image->SetDimensions(refDims[0], refDims[1], slices.size());
+    volume->image->SetSpacing(m.pixelSpacingX, m.pixelSpacingY, m.sliceSpacing);
+    volume->image->SetOrigin(0.0, 0.0, 0.0);
+    volume->image->AllocateScalars(scalarType, components);
+
+    const std::size_t sliceBytes = static_cast<std::size_t>(refDims[0]) * refDims[1] * components *
+                                   volume->image->GetScalarSize();
+    auto* dest = static_cast<unsigned char*>(volume->image->GetScalarPointer());
+
+    imaging::parallelFor(pool, 0, slices.size(), 8, [&](int first, int last) {
+        for (int z = first; z < last; ++z) {
+            memcpy(dest + z * sliceBytes, slices[z]->image->GetScalarPointer(), sliceBytes);
+        }
+    });
+
+    // Slices decoded by the fused unpack kernels already carry their value
+    // counts; binned over the merged range they give computeHistogram()'s result
+    QVector<const models::ValueCounts*> parts;
+    parts.reserve(slices.size());
+    for (const DecodedImagePtr& slice : slices) {
+        parts.append(&slice->valueCounts);
+    }
+    models::ValueCounts total;
+    if (imaging::mergeValueCounts(parts, total)) {
+        volume->histogram = imaging::binValueCounts(total);
+    } else {
+        volume->histogram = imaging::computeHistogram(volume->image, pool);
+    }
+    return volume;
+}
+
+} // namespace services
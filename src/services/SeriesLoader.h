@@ -0,0 +1,32 @@
+#ifndef SERIESLOADER_H
+#define SERIESLOADER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "DicomDecoder.h"
+
+class QThreadPool;
+
+namespace services {
+
+// Loads a series into a single 3D vtkImageData (one slice per instance,
+// ordered by Instance Number). Goes through the fast-open VolumeCache
+// first; on a miss the instances are decoded in parallel and the volume
+// is written back to the cache in the background.
+class SeriesLoader
+{
+public:
+    static QStringList dicomFilesIn(const QString& dirPath);
+
+    static DecodedImagePtr loadDirectory(const QString& dirPath, QThreadPool* pool);
+    static DecodedImagePtr loadFiles(const QStringList& files, QThreadPool* pool);
+
+    // Stacks already decoded single-frame instances of one series.
+    static DecodedImagePtr assemble(QVector<DecodedImagePtr> slices, QThreadPool* pool);
+};
+
+} // namespace services
+
+#endif // SERIESLOADER_H
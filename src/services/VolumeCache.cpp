@@ -0,0 +1,336 @@
+#include "VolumeCache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+
+#include <cstring>
+#include <memory>
+
+namespace services {
+
+namespace {
+
+constexpr char Magic[8] = {'D', 'V', 'V', 'O', 'L', 'U', 'M', 'E'};
+constexpr qint64 PrefixBytes = 40;     // magic + version + reserved + 3 x quint64
+constexpr qint64 DataAlignment = 4096; // voxels start on a page boundary
+constexpr QDataStream::Version StreamVersion = QDataStream::Qt_5_12;
+
+// --- Mapped voxel lifetime ---
+// vtkDataArray only gives its free callback the data pointer, so the
+// QFile owning each mapping is looked up here when VTK releases the array.
+struct Mapping {
+    QFile* file = nullptr;
+    uchar* base = nullptr;
+};
+
+QMutex g_mappingsMutex;
+QHash<void*, Mapping> g_mappings;
+
+void releaseMapping(void* voxels)
+{
+    Mapping mapping;
+    {
+        QMutexLocker locker(&g_mappingsMutex);
+        mapping = g_mappings.take(voxels);
+    }
+    if (mapping.file) {
+        mapping.file->unmap(mapping.base);
+        delete mapping.file;
+    }
+}
+
+// --- Header serialization ---
+void writeMetadata(QDataStream& out, const models::DicomMetadata& m)
+{
+    out << m.patientName << m.patientId << m.studyDate << m.modality << m.institutionName
+        << m.studyInstanceUid << m.seriesInstanceUid << m.sopInstanceUid
+        << qint32(m.instanceNumber) << qint32(m.rows) << qint32(m.columns)
+        << qint32(m.bitsAllocated) << qint32(m.bitsStored) << qint32(m.pixelRepresentation)
+        << qint32(m.samplesPerPixel)
+        << m.windowCenter << m.windowWidth << m.pixelSpacingX << m.pixelSpacingY << m.sliceSpacing
+        << m.rescaleSlope << m.rescaleIntercept << m.rescaleApplied
+        << m.voiLutFunction << m.voiLutData << qint32(m.voiLutFirstMapped) << qint32(m.voiLutBits);
+}
+
+void readMetadata(QDataStream& in, models::DicomMetadata& m)
+{
+    qint32 instanceNumber, rows, columns, bitsAllocated, bitsStored, pixelRepresentation, samplesPerPixel;
+    qint32 voiLutFirstMapped, voiLutBits;
+    in >> m.patientName >> m.patientId >> m.studyDate >> m.modality >> m.institutionName
+       >> m.studyInstanceUid >> m.seriesInstanceUid >> m.sopInstanceUid
+       >> instanceNumber >> rows >> columns
+       >> bitsAllocated >> bitsStored >> pixelRepresentation
+       >> samplesPerPixel
+       >> m.windowCenter >> m.windowWidth >> m.pixelSpacingX >> m.pixelSpacingY >> m.sliceSpacing
+       >> m.rescaleSlope >> m.rescaleIntercept >> m.rescaleApplied
+       >> m.voiLutFunction >> m.voiLutData >> voiLutFirstMapped >> voiLutBits;
+    m.instanceNumber = instanceNumber;
+    m.rows = rows;
+    m.columns = columns;
+    m.bitsAllocated = bitsAllocated;
+    m.bitsStored = bitsStored;
+    m.pixelRepresentation = pixelRepresentation;
+    m.samplesPerPixel = samplesPerPixel;
+    m.voiLutFirstMapped = voiLutFirstMapped;
+    m.voiLutBits = voiLutBits;
+}
+
+} // namespace
+
+VolumeCache& VolumeCache::instance()
+{
+    static VolumeCache instance;
+    return instance;
+}
+
+VolumeCache::VolumeCache()
+{
+    QSettings settings;
+    settings.beginGroup(QStringLiteral("volumeCache"));
+    m_enabled = settings.value(QStringLiteral("enabled"), true).toBool();
+    m_maxBytes = settings.value(QStringLiteral("maxMegabytes"), 4096).toLongLong() * 1024 * 1024;
+    m_directory = settings.value(QStringLiteral("directory"),
+                                 QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                                     + QStringLiteral("/volumes")).toString();
+    settings.endGroup();
+}
+
+bool VolumeCache::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+void VolumeCache::setEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_enabled = enabled;
+}
+
+qint64 VolumeCache::maxBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxBytes;
+}
+
+void VolumeCache::setMaxBytes(qint64 maxBytes)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_maxBytes = maxBytes;
+    }
+    evict();
+}
+
+QString VolumeCache::directory() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_directory;
+}
+
+QString VolumeCache::entryPath(const QStringList& files) const
+{
+    QStringList sorted = files;
+    sorted.sort();
+    const QByteArray key = QCryptographicHash::hash(sorted.join(QLatin1Char('\n')).toUtf8(),
+                                                    QCryptographicHash::Sha1);
+    return QDir(directory()).filePath(QString::fromLatin1(key.toHex()) + QStringLiteral(".dvol"));
+}
+
+QByteArray VolumeCache::fingerprint(const QStringList& files)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QStringList sorted = files;
+    sorted.sort();
+    for (const QString& file : sorted) {
+        const QFileInfo info(file);
+        hash.addData(file.toUtf8());
+        hash.addData(QByteArray::number(info.size()));
+        hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    }
+    return hash.result();
+}
+
+DecodedImagePtr VolumeCache::open(const QStringList& files)
+{
+    if (!isEnabled() || files.isEmpty()) return nullptr;
+
+    const QString path = entryPath(files);
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) return nullptr;
+
+    const qint64 fileSize = file->size();
+    // Private (copy-on-write) mapping: nothing VTK does can touch the file
+    uchar* base = file->map(0, fileSize, QFileDevice::MapPrivateOption);
+    if (!base || fileSize < PrefixBytes) {
+        return nullptr;
+    }
+
+    auto discard = [&]() -> DecodedImagePtr {
+        file->unmap(base);
+        file->close();
+        QFile::remove(path);
+        return nullptr;
+    };
+
+    QDataStream prefix(QByteArray::fromRawData(reinterpret_cast<const char*>(base), PrefixBytes));
+    prefix.setVersion(StreamVersion);
+    char magic[8];
+    quint32 version = 0, reserved = 0;
+    quint64 headerBytes = 0, dataOffset = 0, dataBytes = 0;
+    prefix.readRawData(magic, sizeof(magic));
+    prefix >> version >> reserved >> headerBytes >> dataOffset >> dataBytes;
+
+    if (memcmp(magic, Magic, sizeof(Magic)) != 0 || version != FormatVersion ||
+        PrefixBytes + static_cast<qint64>(headerBytes) > static_cast<qint64>(dataOffset) ||
+        static_cast<qint64>(dataOffset + dataBytes) > fileSize) {
+        return discard();
+    }
+
+    QDataStream header(QByteArray::fromRawData(reinterpret_cast<const char*>(base) + PrefixBytes,
+                                               static_cast<int>(headerBytes)));
+    header.setVersion(StreamVersion);
+
+    QByteArray storedFingerprint;
+    quint8 littleEndian = 0;
+    qint32 dims[3], scalarType = 0, components = 0, scalarSize = 0;
+    double spacing[3], origin[3];
+    auto volume = std::make_shared<DecodedImage>();
+
+    header >> storedFingerprint >> littleEndian;
+    header >> dims[0] >> dims[1] >> dims[2] >> scalarType >> components >> scalarSize;
+    header >> spacing[0] >> spacing[1] >> spacing[2] >> origin[0] >> origin[1] >> origin[2];
+    readMetadata(header, volume->metadata);
+    header >> volume->sourcePath >> volume->histogram.minValue >> volume->histogram.maxValue
+           >> volume->histogram.bins;
+
+    const quint64 valueCount = static_cast<quint64>(dims[0]) * dims[1] * dims[2] * components;
+    if (header.status() != QDataStream::Ok ||
+        storedFingerprint != fingerprint(files) ||
+        littleEndian != (Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? 1 : 0) ||
+        valueCount * static_cast<quint64>(scalarSize) != dataBytes) {
+        // Source files changed (or foreign/corrupt entry): invalidate
+        return discard();
+    }
+
+    vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(
+        vtkDataArray::CreateDataArray(scalarType));
+    if (!scalars || scalars->GetDataTypeSize() != scalarSize) {
+        return discard();
+    }
+
+    uchar* voxels = base + dataOffset;
+    {
+        QMutexLocker locker(&g_mappingsMutex);
+        g_mappings.insert(voxels, Mapping{file.get(), base});
+    }
+    scalars->SetNumberOfComponents(components);
+    scalars->SetVoidArray(voxels, static_cast<vtkIdType>(valueCount), 0,
+                          vtkAbstractArray::VTK_DATA_ARRAY_USER_DEFINED);
+    scalars->SetArrayFreeFunction(&releaseMapping);
+    file.release(); // now owned by the mapping registry
+
+    volume->image = vtkSmartPointer<vtkImageData>::New();
+    volume->image->SetDimensions(dims[0], dims[1], dims[2]);
+    volume->image->SetSpacing(spacing);
+    volume->image->SetOrigin(origin);
+    volume->image->GetPointData()->SetScalars(scalars);
+
+    // Recently opened entries survive eviction longest
+    QFile touch(path);
+    if (touch.open(QIODevice::ReadWrite)) {
+        touch.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+
+    return volume;
+}
+
+bool VolumeCache::store(const QStringList& files, const DecodedImage& volume)
+{
+    if (!isEnabled() || files.isEmpty() || !volume.image) return false;
+
+    vtkImageData* image = volume.image;
+    int dims[3];
+    image->GetDimensions(dims);
+    const int components = image->GetNumberOfScalarComponents();
+    const int scalarSize = image->GetScalarSize();
+    const quint64 dataBytes = static_cast<quint64>(dims[0]) * dims[1] * dims[2] * components * scalarSize;
+
+    if (static_cast<qint64>(dataBytes) > maxBytes()) return false;
+    if (!QDir().mkpath(directory())) return false;
+
+    QByteArray headerBlob;
+    {
+        QDataStream header(&headerBlob, QIODevice::WriteOnly);
+        header.setVersion(StreamVersion);
+        header << fingerprint(files) << quint8(Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? 1 : 0);
+        header << qint32(dims[0]) << qint32(dims[1]) << qint32(dims[2])
+               << qint32(image->GetScalarType()) << qint32(components) << qint32(scalarSize);
+        const double* spacing = image->GetSpacing();
+        const double* origin = image->GetOrigin();
+        header << spacing[0] << spacing[1] << spacing[2] << origin[0] << origin[1] << origin[2];
+        writeMetadata(header, volume.metadata);
+        header << volume.sourcePath << volume.histogram.minValue << volume.histogram.maxValue
+               << volume.histogram.bins;
+    }
+
+    const quint64 headerBytes = static_cast<quint64>(headerBlob.size());
+    const quint64 dataOffset = ((PrefixBytes + headerBytes + DataAlignment - 1) / DataAlignment) * DataAlignment;
+
+    QByteArray prefixBlob;
+    {
+        QDataStream prefix(&prefixBlob, QIODevice::WriteOnly);
+        prefix.setVersion(StreamVersion);
+        prefix.writeRawData(Magic, sizeof(Magic));
+        prefix << FormatVersion << quint32(0) << headerBytes << dataOffset << dataBytes;
+    }
+
+    // QSaveFile: readers never see a half-written entry
+    QSaveFile out(entryPath(files));
+    if (!out.open(QIODevice::WriteOnly)) return false;
+
+    out.write(prefixBlob);
+    out.write(headerBlob);
+    out.write(QByteArray(static_cast<int>(dataOffset - PrefixBytes - headerBytes), '\0'));
+    out.write(static_cast<const char*>(image->GetScalarPointer()), static_cast<qint64>(dataBytes));
+
+    if (!out.commit()) {
+        qWarning() << "VolumeCache: failed to write" << out.fileName();
+        return false;
+    }
+
+    evict();
+    return true;
+}
+
+void VolumeCache::evict()
+{
+    const qint64 limit = maxBytes();
+    QDir dir(directory());
+
+    // Newest first: keep adding until the cap is reached, drop the rest
+    const QFileInfoList entries = dir.entryInfoList(QStringList() << QStringLiteral("*.dvol"),
+                                                    QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (const QFileInfo& entry : entries) {
+        total += entry.size();
+        if (total > limit) {
+            QFile::remove(entry.absoluteFilePath());
+        }
+    }
+}
+
+} // namespace services
@@ -0,0 +1,62 @@
+#ifndef VOLUMECACHE_H
+#define VOLUMECACHE_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include "DicomDecoder.h"
+
+namespace services {
+
+// Optional "fast-open" cache of decoded series. Each entry is a single file:
+// a small header (geometry, DicomMetadata, histogram, source fingerprint)
+// followed by the decoded, Y-flipped, VTK-ready voxels at a page-aligned
+// offset. Opening maps the file straight into a vtkImageData, with no DICOM
+// parsing or decoding.
+//
+// Entries are keyed by the series file list and invalidated when any
+// source file changes size or modification time. The total size is capped;
+// least recently opened entries are evicted first.
+class VolumeCache
+{
+public:
+    static VolumeCache& instance();
+
+    static constexpr quint32 FormatVersion = 4;
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    qint64 maxBytes() const;
+    void setMaxBytes(qint64 maxBytes);
+
+    QString directory() const;
+
+    // Null when missing, outdated or unreadable (stale entries are removed).
+    DecodedImagePtr open(const QStringList& files);
+    bool store(const QStringList& files, const DecodedImage& volume);
+
+    // Hash of the file names, sizes and modification times; changes when
+    // any source file is rewritten
+    static QByteArray fingerprint(const QStringList& files);
+
+private:
+    VolumeCache();
+    ~VolumeCache() = default;
+    VolumeCache(const VolumeCache&) = delete;
+    VolumeCache& operator=(const VolumeCache&) = delete;
+
+    QString entryPath(const QStringList& files) const;
+    void evict();
+
+    mutable QMutex m_mutex;
+    QString m_directory;
+    qint64 m_maxBytes = 0;
+    bool m_enabled = true;
+};
+
+} // namespace services
+
+#endif // VOLUMECACHE_H
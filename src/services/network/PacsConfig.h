@@ -0,0 +1,46 @@
+#ifndef PACSCONFIG_H
+#define PACSCONFIG_H
+
+#include <QSettings>
+#include <QString>
+
+namespace services {
+namespace network {
+
+// Peer and local endpoint settings for DIMSE query/retrieve. Defaults match
+// a dcmqrscp instance on loopback, which is what the subsystem is developed
+// against.
+struct PacsConfig {
+    enum class RetrieveMode { Get, Move };
+
+    QString peerHost = QStringLiteral("localhost");
+    quint16 peerPort = 11112;
+    QString peerAETitle = QStringLiteral("DCMQRSCP");
+    QString localAETitle = QStringLiteral("DICOMVIEWER");
+    quint16 storePort = 11113;
+    int parallelAssociations = 4;
+    RetrieveMode mode = RetrieveMode::Get;
+
+    static PacsConfig load()
+    {
+        PacsConfig config;
+        QSettings settings;
+        settings.beginGroup(QStringLiteral("pacs"));
+        config.peerHost = settings.value(QStringLiteral("peerHost"), config.peerHost).toString();
+        config.peerPort = static_cast<quint16>(settings.value(QStringLiteral("peerPort"), config.peerPort).toUInt());
+        config.peerAETitle = settings.value(QStringLiteral("peerAETitle"), config.peerAETitle).toString();
+        config.localAETitle = settings.value(QStringLiteral("localAETitle"), config.localAETitle).toString();
+        config.storePort = static_cast<quint16>(settings.value(QStringLiteral("storePort"), config.storePort).toUInt());
+        config.parallelAssociations = qMax(1, settings.value(QStringLiteral("parallelAssociations"), config.parallelAssociations).toInt());
+        config.mode = settings.value(QStringLiteral("mode")).toString().compare(QStringLiteral("move"), Qt::CaseInsensitive) == 0
+                          ? RetrieveMode::Move
+                          : RetrieveMode::Get;
+        settings.endGroup();
+        return config;
+    }
+};
+
+} // namespace network
+} // namespace services
+
+#endif // PACSCONFIG_H
@@ -0,0 +1,227 @@
+#include "QueryRetrieveScu.h"
+#include "TransferSyntaxes.h"
+#include "../DecodePipeline.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmnet/dimse.h>
+
+namespace services {
+namespace network {
+
+namespace {
+
+template<typename Response>
+void deleteResponses(OFList<Response*>& responses)
+{
+    for (auto it = responses.begin(); it != responses.end(); ++it) {
+        delete *it;
+    }
+    responses.clear();
+}
+
+QString stringOf(DcmDataset* dataset, const DcmTagKey& tag)
+{
+    OFString value;
+    if (dataset && dataset->findAndGetOFString(tag, value).good()) {
+        return QString::fromLatin1(value.c_str());
+    }
+    return QString();
+}
+
+} // namespace
+
+QueryRetrieveScu::QueryRetrieveScu(const PacsConfig& config, DecodePipeline& pipeline)
+    : m_config(config)
+    , m_pipeline(pipeline)
+{
+    setAETitle(config.localAETitle.toLatin1().constData());
+    setPeerHostName(config.peerHost.toLatin1().constData());
+    setPeerPort(config.peerPort);
+    setPeerAETitle(config.peerAETitle.toLatin1().constData());
+    setACSETimeout(30);
+    setDIMSEBlockingMode(DIMSE_BLOCKING);
+}
+
+QueryRetrieveScu::~QueryRetrieveScu()
+{
+    close();
+}
+
+bool QueryRetrieveScu::open()
+{
+    const OFList<OFString> uncompressed = uncompressedTransferSyntaxes();
+    addPresentationContext(UID_FINDStudyRootQueryRetrieveInformationModel, uncompressed);
+
+    if (m_config.mode == PacsConfig::RetrieveMode::Move) {
+        addPresentationContext(UID_MOVEStudyRootQueryRetrieveInformationModel, uncompressed);
+    } else {
+        addPresentationContext(UID_GETStudyRootQueryRetrieveInformationModel, uncompressed);
+
+        // C-GET sends instances back on this association: we act as the
+        // storage SCP for them.
+        const OFList<OFString> storage = storageTransferSyntaxes();
+        for (int i = 0; i < numberOfDcmShortSCUStorageSOPClassUIDs; ++i) {
+            addPresentationContext(dcmShortSCUStorageSOPClassUIDs[i], storage, ASC_SC_ROLE_SCP);
+        }
+    }
+
+    OFCondition cond = initNetwork();
+    if (cond.good()) {
+        cond = negotiateAssociation();
+    }
+    if (cond.bad()) {
+        qWarning() << "DIMSE: association with" << m_config.peerAETitle << "failed -" << cond.text();
+        return false;
+    }
+    return true;
+}
+
+void QueryRetrieveScu::close()
+{
+    if (isConnected()) {
+        closeAssociation(DCMSCU_RELEASE_ASSOCIATION);
+    }
+}
+
+QVector<InstanceRef> QueryRetrieveScu::find(DcmDataset& query)
+{
+    QVector<InstanceRef> result;
+
+    const T_ASC_PresentationContextID presID =
+        findAnyPresentationContextID(UID_FINDStudyRootQueryRetrieveInformationModel, "");
+    if (presID == 0) {
+        qWarning() << "DIMSE: no accepted presentation context for C-FIND";
+        return result;
+    }
+
+    OFList<QRResponse*> responses;
+    OFCondition cond = sendFINDRequest(presID, &query, &responses);
+    if (cond.bad()) {
+        qWarning() << "DIMSE: C-FIND failed -" << cond.text();
+    }
+
+    for (auto it = responses.begin(); it != responses.end(); ++it) {
+        DcmDataset* identifier = (*it)->m_dataset;
+        if (!identifier) continue; // final response carries no identifier
+
+        InstanceRef ref;
+        ref.studyInstanceUid = stringOf(identifier, DCM_StudyInstanceUID);
+        ref.seriesInstanceUid = stringOf(identifier, DCM_SeriesInstanceUID);
+        ref.sopInstanceUid = stringOf(identifier, DCM_SOPInstanceUID);
+        ref.instanceNumber = stringOf(identifier, DCM_InstanceNumber).trimmed().toInt();
+        result.append(ref);
+    }
+    deleteResponses(responses);
+
+    return result;
+}
+
+QVector<InstanceRef> QueryRetrieveScu::findInstances(const QString& studyInstanceUid)
+{
+    DcmDataset seriesQuery;
+    seriesQuery.putAndInsertOFStringArray(DCM_QueryRetrieveLevel, "SERIES");
+    seriesQuery.putAndInsertOFStringArray(DCM_StudyInstanceUID, studyInstanceUid.toLatin1().constData());
+    seriesQuery.putAndInsertOFStringArray(DCM_SeriesInstanceUID, "");
+
+    QVector<InstanceRef> instances;
+    const QVector<InstanceRef> series = find(seriesQuery);
+    for (const InstanceRef& s : series) {
+        DcmDataset imageQuery;
+        imageQuery.putAndInsertOFStringArray(DCM_QueryRetrieveLevel, "IMAGE");
+        imageQuery.putAndInsertOFStringArray(DCM_StudyInstanceUID, studyInstanceUid.toLatin1().constData());
+        imageQuery.putAndInsertOFStringArray(DCM_SeriesInstanceUID, s.seriesInstanceUid.toLatin1().constData());
+        imageQuery.putAndInsertOFStringArray(DCM_SOPInstanceUID, "");
+        imageQuery.putAndInsertOFStringArray(DCM_InstanceNumber, "");
+
+        QVector<InstanceRef> images = find(imageQuery);
+        std::sort(images.begin(), images.end(), [](const InstanceRef& a, const InstanceRef& b) {
+            return a.instanceNumber < b.instanceNumber;
+        });
+        for (InstanceRef& image : images) {
+            image.studyInstanceUid = studyInstanceUid;
+            image.seriesInstanceUid = s.seriesInstanceUid;
+        }
+        instances += images;
+    }
+
+    return instances;
+}
+
+bool QueryRetrieveScu::retrieve(const InstanceRef& instance)
+{
+    DcmDataset identifier;
+    identifier.putAndInsertOFStringArray(DCM_QueryRetrieveLevel, "IMAGE");
+    identifier.putAndInsertOFStringArray(DCM_StudyInstanceUID, instance.studyInstanceUid.toLatin1().constData());
+    identifier.putAndInsertOFStringArray(DCM_SeriesInstanceUID, instance.seriesInstanceUid.toLatin1().constData());
+    identifier.putAndInsertOFStringArray(DCM_SOPInstanceUID, instance.sopInstanceUid.toLatin1().constData());
+
+    OFList<RetrieveResponse*> responses;
+    OFCondition cond;
+
+    if (m_config.mode == PacsConfig::RetrieveMode::Move) {
+        const T_ASC_PresentationContextID presID =
+            findAnyPresentationContextID(UID_MOVEStudyRootQueryRetrieveInformationModel, "");
+        if (presID == 0) return false;
+        cond = sendMOVERequest(presID, m_config.localAETitle.toLatin1().constData(), &identifier, &responses);
+    } else {
+        const T_ASC_PresentationContextID presID =
+            findAnyPresentationContextID(UID_GETStudyRootQueryRetrieveInformationModel, "");
+        if (presID == 0) return false;
+        cond = sendCGETRequest(presID, &identifier, &responses);
+    }
+
+    bool ok = cond.good();
+    if (ok && !responses.empty()) {
+        const RetrieveResponse* last = responses.back();
+        ok = last->m_status == STATUS_Success;
+        // A Warning ends a retrieve whose sub-operations failed: for a single
+        // instance that means no dataset reached us, so it is not delivered
+        if (DICOM_WARNING_STATUS(last->m_status)) {
+            ok = last->m_numberOfFailedSubops == 0 && last->m_numberOfWarningSubops == 0;
+            if (!ok) {
+                qWarning().noquote() << QString("DIMSE: retrieve of %1 ended with warning 0x%2 "
+                                                "(%3 completed, %4 failed, %5 warning sub-operations)")
+                                            .arg(instance.sopInstanceUid)
+                                            .arg(last->m_status, 4, 16, QChar('0'))
+                                            .arg(last->m_numberOfCompletedSubops)
+                                            .arg(last->m_numberOfFailedSubops)
+                                            .arg(last->m_numberOfWarningSubops);
+            }
+        }
+    }
+    deleteResponses(responses);
+
+    if (!ok) {
+        qWarning() << "DIMSE: retrieve of" << instance.sopInstanceUid << "failed -" << cond.text();
+    }
+    return ok;
+}
+
+OFCondition QueryRetrieveScu::handleSTORERequest(const T_ASC_PresentationContextID /*presID*/,
+                                                 DcmDataset* incomingObject,
+                                                 OFBool& continueCGETSession,
+                                                 Uint16& cStoreReturnStatus)
+{
+    continueCGETSession = OFTrue;
+
+    if (!incomingObject) {
+        cStoreReturnStatus = STATUS_STORE_Error_CannotUnderstand;
+        return EC_IllegalParameter;
+    }
+
+    // DcmSCU owns incomingObject and frees it after this call. The SOP
+    // Instance UID is the origin, so a failed decode can be matched to
+    // its retrieve.
+    OFString sopInstanceUid;
+    incomingObject->findAndGetOFString(DCM_SOPInstanceUID, sopInstanceUid);
+    m_pipeline.submit(new DcmDataset(*incomingObject), QString::fromLatin1(sopInstanceUid.c_str()));
+    cStoreReturnStatus = STATUS_Success;
+    return EC_Normal;
+}
+
+} // namespace network
+} // namespace services
@@ -0,0 +1,59 @@
+#ifndef QUERYRETRIEVESCU_H
+#define QUERYRETRIEVESCU_H
+
+#include <QString>
+#include <QVector>
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmnet/scu.h>
+
+#include "PacsConfig.h"
+
+namespace services {
+
+class DecodePipeline;
+
+namespace network {
+
+struct InstanceRef {
+    QString studyInstanceUid;
+    QString seriesInstanceUid;
+    QString sopInstanceUid;
+    int instanceNumber = 0;
+};
+
+// One Study Root C-FIND/C-MOVE/C-GET association. C-GET sub-operations are
+// received on the same association and streamed into the decode pipeline;
+// C-MOVE sub-operations arrive at the StoreScp instead.
+class QueryRetrieveScu : public DcmSCU
+{
+public:
+    QueryRetrieveScu(const PacsConfig& config, DecodePipeline& pipeline);
+    ~QueryRetrieveScu() override;
+
+    bool open();
+    void close();
+
+    // SERIES then IMAGE level queries (hierarchical model requires the
+    // series UID at IMAGE level). Ordered by series, then Instance Number.
+    QVector<InstanceRef> findInstances(const QString& studyInstanceUid);
+
+    bool retrieve(const InstanceRef& instance);
+
+protected:
+    OFCondition handleSTORERequest(const T_ASC_PresentationContextID presID,
+                                   DcmDataset* incomingObject,
+                                   OFBool& continueCGETSession,
+                                   Uint16& cStoreReturnStatus) override;
+
+private:
+    QVector<InstanceRef> find(DcmDataset& query);
+
+    PacsConfig m_config;
+    DecodePipeline& m_pipeline;
+};
+
+} // namespace network
+} // namespace services
+
+#endif // QUERYRETRIEVESCU_H
@@ -0,0 +1,249 @@
+#include "RetrieveService.h"
+#include "QueryRetrieveScu.h"
+#include "../DecodePipeline.h"
+#include "../SeriesLoader.h"
+
+#include <QDebug>
+
+#include <QHash>
+
+#include <vector>
+
+namespace services {
+namespace network {
+
+RetrieveService::RetrieveService(DecodePipeline& pipeline, QObject* parent)
+    : QObject(parent)
+    , m_pipeline(pipeline)
+    , m_config(PacsConfig::load())
+    , m_storeScp(pipeline)
+{
+    qRegisterMetaType<services::network::RetrieveStats>();
+
+    connect(&m_pipeline, &DecodePipeline::imageDecoded,
+            this, &RetrieveService::onImageDecoded, Qt::QueuedConnection);
+    connect(&m_pipeline, &DecodePipeline::decodeFailed,
+            this, &RetrieveService::onDecodeFailed, Qt::QueuedConnection);
+    connect(&m_storeScp, &StoreScp::listenFailed, this, [this](const QString& error) {
+        emit errorOccurred(QString("Receptor C-STORE na porta %1 falhou: %2").arg(m_config.storePort).arg(error));
+        // C-MOVE sub-operations cannot reach us any more
+        if (m_busy && m_config.mode == PacsConfig::RetrieveMode::Move) {
+            cancel();
+        }
+    }, Qt::QueuedConnection);
+}
+
+RetrieveService::~RetrieveService()
+{
+    cancel();
+    if (m_controller.joinable()) {
+        m_controller.join();
+    }
+    m_storeScp.stop();
+}
+
+bool RetrieveService::retrieveStudy(const QString& studyInstanceUid)
+{
+    if (m_busy) {
+        emit errorOccurred("Já existe uma recuperação em andamento");
+        return false;
+    }
+    if (studyInstanceUid.isEmpty()) {
+        emit errorOccurred("Study Instance UID vazio");
+        return false;
+    }
+    if (m_controller.joinable()) {
+        m_controller.join();
+    }
+
+    if (m_config.mode == PacsConfig::RetrieveMode::Move && !m_storeScp.isRunning()) {
+        if (!m_storeScp.start(m_config.localAETitle, m_config.storePort, m_config.parallelAssociations * 2)) {
+            emit errorOccurred(QString("Falha ao iniciar o receptor C-STORE na porta %1").arg(m_config.storePort));
+            return false;
+        }
+    }
+
+    m_busy = true;
+    m_networkDone = false;
+    m_cancel = false;
+    m_stats = RetrieveStats();
+    m_outstanding.clear();
+    m_received.clear();
+    m_studyInstanceUid = studyInstanceUid;
+    m_timer.start();
+
+    m_controller = std::thread(&RetrieveService::runRetrieve, this, studyInstanceUid, m_config);
+    return true;
+}
+
+void RetrieveService::cancel()
+{
+    m_cancel = true;
+}
+
+// Runs on the controller thread: nothing here may touch QObject state
+// directly, results are posted back to the owner thread.
+void RetrieveService::runRetrieve(const QString& studyInstanceUid, const PacsConfig& config)
+{
+    QVector<InstanceRef> instances;
+    {
+        QueryRetrieveScu finder(config, m_pipeline);
+        if (!finder.open()) {
+            QMetaObject::invokeMethod(this, [this, config]() {
+                onNetworkFinished(QString("Falha ao conectar ao PACS %1@%2:%3")
+                                      .arg(config.peerAETitle, config.peerHost)
+                                      .arg(config.peerPort), QStringList());
+            }, Qt::QueuedConnection);
+            return;
+        }
+        instances = finder.findInstances(studyInstanceUid);
+    }
+
+    const int total = instances.size();
+    QStringList sopInstanceUids;
+    for (const InstanceRef& instance : instances) {
+        sopInstanceUids << instance.sopInstanceUid;
+    }
+    QMetaObject::invokeMethod(this, [this, sopInstanceUids]() { onInstancesFound(sopInstanceUids); },
+                              Qt::QueuedConnection);
+
+    if (total == 0) {
+        QMetaObject::invokeMethod(this, [this]() {
+            onNetworkFinished("Nenhuma imagem encontrada para o estudo", QStringList());
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    // Instances are ordered by Instance Number, and every association pulls
+    // the next one from a shared cursor, so the first slices arrive first.
+    std::atomic<int> next{0};
+    std::atomic<int> failures{0};
+    std::vector<char> delivered(total, 0); // one writer per index
+    const int workerCount = qMin(config.parallelAssociations, total);
+
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+    for (int w = 0; w < workerCount; ++w) {
+        workers.emplace_back([&]() {
+            QueryRetrieveScu scu(config, m_pipeline);
+            if (!scu.open()) return;
+
+            for (int i = next++; i < total && !m_cancel; i = next++) {
+                if (scu.retrieve(instances[i])) {
+                    delivered[i] = 1;
+                } else {
+                    ++failures;
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    QString error;
+    if (next.load() == 0) {
+        error = "Falha ao abrir associações com o PACS";
+    } else if (failures.load() > 0) {
+        error = QString("%1 imagens não puderam ser recuperadas").arg(failures.load());
+    }
+
+    // Failed or cancelled instances will never reach the pipeline
+    QStringList undelivered;
+    for (int i = 0; i < total; ++i) {
+        if (!delivered[i]) {
+            undelivered << instances[i].sopInstanceUid;
+        }
+    }
+
+    QMetaObject::invokeMethod(this, [this, error, undelivered]() { onNetworkFinished(error, undelivered); },
+                              Qt::QueuedConnection);
+}
+
+void RetrieveService::onInstancesFound(const QStringList& sopInstanceUids)
+{
+    m_stats.imagesExpected = sopInstanceUids.size();
+    m_outstanding = QSet<QString>(sopInstanceUids.begin(), sopInstanceUids.end());
+    emit progress(m_stats.imagesReceived, m_stats.imagesExpected);
+}
+
+void RetrieveService::onImageDecoded(const services::DecodedImagePtr& image)
+{
+    // Only instances this retrieve asked for: other viewports and pushes
+    // to the StoreScp share the pipeline
+    if (!m_busy || !image || !m_outstanding.remove(image->metadata.sopInstanceUid)) return;
+
+    ++m_stats.imagesReceived;
+    m_received.append(image);
+    if (m_stats.timeToFirstImageMs < 0) {
+        m_stats.timeToFirstImageMs = m_timer.elapsed();
+        emit firstImageReady(image);
+    }
+
+    emit progress(m_stats.imagesReceived, m_stats.imagesExpected);
+    finishIfDone();
+}
+
+void RetrieveService::onDecodeFailed(const QString& origin)
+{
+    if (!m_busy || !m_outstanding.remove(origin)) return;
+    finishIfDone();
+}
+
+void RetrieveService::onNetworkFinished(const QString& error, const QStringList& undelivered)
+{
+    for (const QString& sopInstanceUid : undelivered) {
+        m_outstanding.remove(sopInstanceUid);
+    }
+    m_networkDone = true;
+    if (!error.isEmpty()) {
+        emit errorOccurred(error);
+    }
+    finishIfDone();
+}
+
+void RetrieveService::finishIfDone()
+{
+    if (!m_busy || !m_networkDone || !m_outstanding.isEmpty()) return;
+
+    m_busy = false;
+    m_stats.elapsedMs = m_timer.elapsed();
+    assembleSeries();
+
+    qInfo().noquote() << QString("PACS retrieve: %1/%2 images in %3 ms (%4 images/s), time-to-first-image %5 ms")
+                             .arg(m_stats.imagesReceived)
+                             .arg(m_stats.imagesExpected)
+                             .arg(m_stats.elapsedMs)
+                             .arg(m_stats.imagesPerSecond(), 0, 'f', 1)
+                             .arg(m_stats.timeToFirstImageMs);
+
+    emit finished(m_stats);
+}
+
+void RetrieveService::assembleSeries()
+{
+    // Group by series, in arrival order of each series' first instance
+    QVector<QString> order;
+    QHash<QString, QVector<DecodedImagePtr>> bySeries;
+    for (const DecodedImagePtr& image : m_received) {
+        const QString& seriesUid = image->metadata.seriesInstanceUid;
+        if (!bySeries.contains(seriesUid)) {
+            order.append(seriesUid);
+        }
+        bySeries[seriesUid].append(image);
+    }
+    m_received.clear();
+
+    for (const QString& seriesUid : order) {
+        const QVector<DecodedImagePtr>& slices = bySeries[seriesUid];
+        DecodedImagePtr volume = slices.size() == 1
+            ? slices.first()
+            : SeriesLoader::assemble(slices, m_pipeline.threadPool());
+        if (volume) {
+            emit seriesReady(volume);
+        }
+    }
+}
+
+} // namespace network
+} // namespace services
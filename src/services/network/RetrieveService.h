@@ -0,0 +1,100 @@
+#ifndef RETRIEVESERVICE_H
+#define RETRIEVESERVICE_H
+
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "PacsConfig.h"
+#include "StoreScp.h"
+#include "../DicomDecoder.h"
+
+namespace services {
+
+class DecodePipeline;
+
+namespace network {
+
+struct RetrieveStats {
+    int imagesExpected = 0;
+    int imagesReceived = 0;
+    qint64 timeToFirstImageMs = -1;
+    qint64 elapsedMs = 0;
+
+    double imagesPerSecond() const
+    {
+        return elapsedMs > 0 ? imagesReceived * 1000.0 / elapsedMs : 0.0;
+    }
+};
+
+// Fetches a whole study: one C-FIND association lists the instances, then
+// several associations pull them in parallel (C-GET, or C-MOVE towards our
+// own StoreScp). Instances are decoded as they arrive, and the first one is
+// announced immediately so it can be displayed while the rest downloads;
+// once everything is in, each series is stacked into a volume.
+class RetrieveService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RetrieveService(DecodePipeline& pipeline, QObject* parent = nullptr);
+    ~RetrieveService() override;
+
+    void setConfig(const PacsConfig& config) { m_config = config; }
+    const PacsConfig& config() const { return m_config; }
+
+    bool retrieveStudy(const QString& studyInstanceUid);
+    bool isBusy() const { return m_busy; }
+    void cancel();
+
+signals:
+    void firstImageReady(const services::DecodedImagePtr& image);
+    // One per retrieved series, emitted right before finished()
+    void seriesReady(const services::DecodedImagePtr& volume);
+    void progress(int received, int expected);
+    void finished(const services::network::RetrieveStats& stats);
+    void errorOccurred(const QString& error);
+
+private slots:
+    void onImageDecoded(const services::DecodedImagePtr& image);
+    void onDecodeFailed(const QString& origin);
+
+private:
+    void runRetrieve(const QString& studyInstanceUid, const PacsConfig& config);
+    void onInstancesFound(const QStringList& sopInstanceUids);
+    void onNetworkFinished(const QString& error, const QStringList& undelivered);
+    void finishIfDone();
+    void assembleSeries();
+
+    DecodePipeline& m_pipeline;
+    PacsConfig m_config;
+    StoreScp m_storeScp;
+
+    std::thread m_controller;
+    std::atomic<bool> m_cancel{false};
+
+    bool m_busy = false;
+    bool m_networkDone = false;
+    QString m_studyInstanceUid;
+    // Instances of this retrieve still to be decoded (by SOP Instance
+    // UID); the shared pipeline also decodes for other clients
+    QSet<QString> m_outstanding;
+    QVector<DecodedImagePtr> m_received;
+    QElapsedTimer m_timer;
+    RetrieveStats m_stats;
+};
+
+} // namespace network
+} // namespace services
+
+Q_DECLARE_METATYPE(services::network::RetrieveStats)
+
+#endif // RETRIEVESERVICE_H
@@ -0,0 +1,144 @@
+#include "StoreScp.h"
+#include "TransferSyntaxes.h"
+#include "../DecodePipeline.h"
+
+#include <QDebug>
+
+#include <dcmtk/dcmnet/scp.h>
+#include <dcmtk/dcmnet/scppool.h>
+#include <dcmtk/dcmnet/dimse.h>
+
+namespace services {
+namespace network {
+
+namespace {
+
+// DcmSCPPool default-constructs its workers, so they reach the pipeline
+// through this process-wide sink (owned by the running StoreScp).
+std::atomic<DecodePipeline*> g_sink{nullptr};
+std::atomic<int> g_received{0};
+
+class StoreHandler : public DcmSCP
+{
+protected:
+    OFCondition handleIncomingCommand(T_DIMSE_Message* incomingMsg,
+                                      const DcmPresentationContextInfo& presInfo) override
+    {
+        if (incomingMsg->CommandField != DIMSE_C_STORE_RQ) {
+            // C-ECHO and friends
+            return DcmSCP::handleIncomingCommand(incomingMsg, presInfo);
+        }
+
+        T_DIMSE_C_StoreRQ& request = incomingMsg->msg.CStoreRQ;
+        DcmDataset* dataset = nullptr;
+        OFCondition cond = receiveSTORERequest(request, presInfo.presentationContextID, dataset);
+        if (cond.bad()) {
+            delete dataset;
+            return cond;
+        }
+
+        Uint16 status = STATUS_STORE_Refused_OutOfResources;
+        if (DecodePipeline* sink = g_sink.load()) {
+            // Hand-off only; decoding happens on the pipeline workers so the
+            // association keeps receiving at network speed.
+            sink->submit(dataset, QString::fromLatin1(request.AffectedSOPInstanceUID));
+            ++g_received;
+            status = STATUS_Success;
+        } else {
+            delete dataset;
+        }
+
+        return sendSTOREResponse(presInfo.presentationContextID, request, status);
+    }
+};
+
+} // namespace
+
+class StoreScp::Pool : public DcmSCPPool<StoreHandler>
+{
+};
+
+StoreScp::StoreScp(DecodePipeline& pipeline, QObject* parent)
+    : QObject(parent)
+    , m_pipeline(pipeline)
+{
+}
+
+StoreScp::~StoreScp()
+{
+    stop();
+}
+
+bool StoreScp::start(const QString& aeTitle, quint16 port, int maxAssociations)
+{
+    if (m_running) return true;
+
+    // A previous listen that ended on its own (e.g. failed to bind)
+    if (m_listenThread.joinable()) {
+        m_listenThread.join();
+    }
+    m_pool.reset();
+
+    DecodePipeline* expected = nullptr;
+    if (!g_sink.compare_exchange_strong(expected, &m_pipeline)) {
+        qWarning() << "StoreSCP: another receiver is already running";
+        return false;
+    }
+
+    m_pool = std::make_unique<Pool>();
+
+    DcmSCPConfig& config = m_pool->getConfig();
+    config.setAETitle(aeTitle.toLatin1().constData());
+    config.setPort(port);
+    config.setHostLookupEnabled(OFFalse);
+    // Non-blocking accept so stop() is honoured within a second
+    config.setConnectionBlockingMode(DUL_NOBLOCK);
+    config.setConnectionTimeout(1);
+
+    const OFList<OFString> syntaxes = storageTransferSyntaxes();
+    config.addPresentationContext(UID_VerificationSOPClass, uncompressedTransferSyntaxes());
+    for (int i = 0; i < numberOfDcmAllStorageSOPClassUIDs; ++i) {
+        config.addPresentationContext(dcmAllStorageSOPClassUIDs[i], syntaxes);
+    }
+
+    m_pool->setMaxThreads(static_cast<Uint16>(qMax(1, maxAssociations)));
+
+    g_received = 0;
+    m_running = true;
+    m_listenThread = std::thread([this]() {
+        OFCondition cond = m_pool->listen();
+        m_running = false;
+        if (cond.bad()) {
+            qWarning() << "StoreSCP: listen failed -" << cond.text();
+            // Give the slot back so a later start() can try again
+            DecodePipeline* owned = &m_pipeline;
+            g_sink.compare_exchange_strong(owned, nullptr);
+            emit listenFailed(QString::fromLatin1(cond.text()));
+        }
+    });
+
+    return true;
+}
+
+void StoreScp::stop()
+{
+    if (!m_pool) return;
+
+    m_pool->stopAfterCurrentAssociations();
+    if (m_listenThread.joinable()) {
+        m_listenThread.join();
+    }
+    m_pool.reset();
+    m_running = false;
+
+    DecodePipeline* owned = &m_pipeline;
+    g_sink.compare_exchange_strong(owned, nullptr);
+}
+
+int StoreScp::receivedCount() const
+{
+    return g_received.load();
+}
+
+} // namespace network
+} // namespace services
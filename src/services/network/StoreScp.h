@@ -0,0 +1,52 @@
+#ifndef STORESCP_H
+#define STORESCP_H
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace services {
+
+class DecodePipeline;
+
+namespace network {
+
+// C-STORE SCP that hands every received instance straight to the decode
+// pipeline, without touching the disk. Associations are served concurrently
+// by a DCMTK SCP pool. Only one receiver may run per process, because the
+// pool creates its workers without arguments.
+class StoreScp : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StoreScp(DecodePipeline& pipeline, QObject* parent = nullptr);
+    ~StoreScp() override;
+
+    bool start(const QString& aeTitle, quint16 port, int maxAssociations = 8);
+    void stop();
+
+    bool isRunning() const { return m_running.load(); }
+    int receivedCount() const;
+
+signals:
+    // Emitted from the listen thread when the port cannot be opened (e.g.
+    // already in use); the receiver has released the process-wide slot
+    void listenFailed(const QString& error);
+
+private:
+    class Pool;
+
+    DecodePipeline& m_pipeline;
+    std::unique_ptr<Pool> m_pool;
+    std::thread m_listenThread;
+    std::atomic<bool> m_running{false};
+};
+
+} // namespace network
+} // namespace services
+
+#endif // STORESCP_H
@@ -0,0 +1,40 @@
+#ifndef TRANSFERSYNTAXES_H
+#define TRANSFERSYNTAXES_H
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcuid.h>
+#include <dcmtk/ofstd/oflist.h>
+#include <dcmtk/ofstd/ofstring.h>
+
+namespace services {
+namespace network {
+
+// Transfer syntaxes we can decode locally (uncompressed + the JPEG family
+// registered through DJDecoderRegistration), in order of preference.
+// Accepting compressed syntaxes spares the PACS from transcoding.
+inline OFList<OFString> storageTransferSyntaxes()
+{
+    OFList<OFString> syntaxes;
+    syntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
+    syntaxes.push_back(UID_JPEGProcess14SV1TransferSyntax);
+    syntaxes.push_back(UID_JPEGProcess14TransferSyntax);
+    syntaxes.push_back(UID_JPEGProcess1TransferSyntax);
+    syntaxes.push_back(UID_JPEGProcess2_4TransferSyntax);
+    syntaxes.push_back(UID_BigEndianExplicitTransferSyntax);
+    syntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+    return syntaxes;
+}
+
+inline OFList<OFString> uncompressedTransferSyntaxes()
+{
+    OFList<OFString> syntaxes;
+    syntaxes.push_back(UID_LittleEndianExplicitTransferSyntax);
+    syntaxes.push_back(UID_BigEndianExplicitTransferSyntax);
+    syntaxes.push_back(UID_LittleEndianImplicitTransferSyntax);
+    return syntaxes;
+}
+
+} // namespace network
+} // namespace services
+
+#endif // TRANSFERSYNTAXES_H
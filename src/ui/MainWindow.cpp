@@ -1,10 +1,18 @@
 #include "MainWindow.h"
 #include "ui_mainwindow.h"
 #include "styles/StyleManager.h"
+#include "../services/SeriesLoader.h"
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDebug>
+#include <QEvent>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
 #include <QMessageBox>
 #include <QVBoxLayout>
 #include <QSlider>
+#include <QTimer>
 
 #include <QVTKOpenGLNativeWidget.h>
 #include <vtkAutoInit.h>
@@ -18,6 +26,7 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
     resize(1024, 800);
+    setupServices();
     setupViewer();
     setupConnections();
     applyStyles();
@@ -25,12 +34,85 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // Network threads post into the pipeline: stop them first
+    delete m_retrieveService;
+    delete m_exportEngine;
     delete ui;
 }
 
+void MainWindow::openAtStartup(const QStringList& paths, const QElapsedTimer& startup)
+{
+    const QStringList opened = paths.mid(0, MaxStartupPaths);
+
+    m_startup = startup;
+    m_awaitingWindow = true;
+    m_awaitingFirstImage = !opened.isEmpty();
+
+    if (paths.size() > MaxStartupPaths) {
+        qWarning() << "Startup:" << paths.size() - MaxStartupPaths << "paths beyond the 4x4 layout were ignored";
+    }
+
+    // Smallest layout that fits (combo order: 1x1, 1x2, 2x2, 4x4)
+    const int count = opened.size();
+    ui->layoutComboBox->setCurrentIndex(count <= 1 ? 0 : count == 2 ? 1 : count <= 4 ? 2 : 3);
+
+    // Decoding already started in main(); prefetch() again only to be told
+    // when each path is ready (at once if it already is). The GUI thread
+    // never waits for a decode, so the window keeps painting meanwhile.
+    connect(m_core.get(), &services::ImagingCore::loaded,
+            this, &MainWindow::onStartupLoaded, Qt::QueuedConnection);
+
+    const QVector<viewer::DicomViewer*>& viewers = m_viewports->viewers();
+    for (int i = 0; i < count && i < viewers.size(); ++i) {
+        // The same path given twice fills both viewports from one decode
+        const QString path = services::ImagingCore::normalizedPath(opened[i]);
+        const bool queued = m_startupTargets.contains(path);
+        m_startupTargets[path].append(viewers[i]);
+        if (!queued) m_core->prefetch(path);
+    }
+}
+
+bool MainWindow::event(QEvent* event)
+{
+    const bool handled = QMainWindow::event(event);
+
+    // First paint: the window (and the viewports' GL context) is on screen
+    if (m_awaitingWindow && event->type() == QEvent::Paint) {
+        m_awaitingWindow = false;
+        m_timeToWindowMs = m_startup.elapsed();
+        qInfo().noquote() << QString("Startup: window in %1 ms").arg(m_timeToWindowMs);
+    }
+    return handled;
+}
+
+void MainWindow::onStartupLoaded(const QString& path, const services::DecodedImagePtr& image)
+{
+    const auto it = m_startupTargets.find(path);
+    if (it == m_startupTargets.end()) return; // some other load
+
+    const QVector<QPointer<viewer::DicomViewer>> targets = it.value();
+    m_startupTargets.erase(it);
+    if (m_startupTargets.isEmpty()) {
+        disconnect(m_core.get(), &services::ImagingCore::loaded, this, &MainWindow::onStartupLoaded);
+    }
+
+    if (!image) {
+        onViewerError(QString("Falha ao carregar %1").arg(path));
+    } else {
+        for (const QPointer<viewer::DicomViewer>& viewer : targets) {
+            if (viewer) viewer->showImage(image);
+        }
+    }
+
+    if (m_startupTargets.isEmpty() && m_awaitingFirstImage) {
+        m_awaitingFirstImage = false; // none of the paths could be opened
+    }
+}
+
 void MainWindow::setupViewer()
 {
-    m_viewer = new viewer::DicomViewer(this);
+    m_viewports = new viewer::ViewportGrid(this);
+    m_viewer = m_viewports->activeViewer();
 
     QLayout* layout = ui->viewerArea->layout();
     if (layout) {
@@ -39,30 +121,73 @@ void MainWindow::setupViewer()
             delete item->widget();
             delete item;
         }
-        layout->addWidget(m_viewer);
+        layout->addWidget(m_viewports);
     } else {
         QVBoxLayout* newLayout = new QVBoxLayout(ui->viewerArea);
         newLayout->setContentsMargins(0, 0, 0, 0);
-        newLayout->addWidget(m_viewer);
+        newLayout->addWidget(m_viewports);
     }
 }
 
+void MainWindow::setupServices()
+{
+    m_core = services::ImagingCore::acquire();
+    m_retrieveService = new services::network::RetrieveService(m_core->decodePipeline());
+    m_exportEngine = new services::ExportEngine(m_core->threadPool());
+}
+
 void MainWindow::setupConnections()
 {
     connect(ui->pushLerDicomButton, &QPushButton::clicked,
             this, &MainWindow::onOpenFileClicked);
+    connect(ui->pushAbrirSerieButton, &QPushButton::clicked,
+            this, &MainWindow::onOpenSeriesClicked);
+    connect(ui->pushPacsButton, &QPushButton::clicked,
+            this, &MainWindow::onRetrieveFromPacsClicked);
+    connect(ui->pushExportButton, &QPushButton::clicked,
+            this, &MainWindow::onExportClicked);
     connect(ui->pushSairButton, &QPushButton::clicked,
             this, &MainWindow::onExitClicked);
 
-    connect(m_viewer, &viewer::DicomViewer::imageLoaded,
+    connect(m_exportEngine, &services::ExportEngine::finished,
+            this, &MainWindow::onExportFinished);
+
+    connect(m_retrieveService, &services::network::RetrieveService::firstImageReady,
+            this, &MainWindow::onRetrieveFirstImage);
+    connect(m_retrieveService, &services::network::RetrieveService::seriesReady,
+            this, &MainWindow::onRetrieveSeriesReady);
+    connect(m_retrieveService, &services::network::RetrieveService::progress,
+            this, &MainWindow::onRetrieveProgress);
+    connect(m_retrieveService, &services::network::RetrieveService::finished,
+            this, &MainWindow::onRetrieveFinished);
+    connect(m_retrieveService, &services::network::RetrieveService::errorOccurred,
+            this, &MainWindow::onViewerError);
+
+    connect(m_viewports, &viewer::ViewportGrid::imageLoaded,
             this, &MainWindow::onImageLoaded);
-    connect(m_viewer, &viewer::DicomViewer::errorOccurred,
+    connect(m_viewports, &viewer::ViewportGrid::activeViewerChanged,
+            this, &MainWindow::onActiveViewerChanged);
+    connect(m_viewports, &viewer::ViewportGrid::errorOccurred,
             this, &MainWindow::onViewerError);
 
+    connect(ui->layoutComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onLayoutChanged);
+    connect(ui->linkViewportsCheckBox, &QCheckBox::toggled,
+            m_viewports, &viewer::ViewportGrid::setLinked);
+
     connect(ui->windowWidthSlider, &QSlider::valueChanged,
             this, &MainWindow::onWindowWidthChanged);
     connect(ui->windowLevelSlider, &QSlider::valueChanged,
             this, &MainWindow::onWindowLevelChanged);
+    connect(ui->sliceSlider, &QSlider::valueChanged,
+            this, &MainWindow::onSliceSliderChanged);
+
+    connect(ui->projectionComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onProjectionChanged);
+    connect(ui->projectionAxisComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onProjectionChanged);
+    connect(ui->slabThicknessSlider, &QSlider::valueChanged,
+            this, &MainWindow::onProjectionChanged);
 }
 
 void MainWindow::applyStyles()
@@ -72,11 +197,19 @@ void MainWindow::applyStyles()
     setStyleSheet(style.mainWindowStyle());
     ui->sidePanel->setStyleSheet(style.sidePanelStyle());
     ui->pushLerDicomButton->setStyleSheet(style.primaryButtonStyle());
+    ui->pushAbrirSerieButton->setStyleSheet(style.secondaryButtonStyle());
+    ui->pushPacsButton->setStyleSheet(style.secondaryButtonStyle());
+    ui->pushExportButton->setStyleSheet(style.secondaryButtonStyle());
     ui->pushSairButton->setStyleSheet(style.secondaryButtonStyle());
     ui->logoLabel->setStyleSheet(style.labelTitleStyle());
     ui->subtitleLabel->setStyleSheet(style.labelSubtitleStyle());
     ui->versionLabel->setStyleSheet(style.labelMutedStyle());
+    ui->statusLabel->setStyleSheet(style.labelSubtitleStyle());
     ui->viewerArea->setStyleSheet(style.viewerAreaStyle());
+    ui->layoutComboBox->setStyleSheet(style.comboBoxStyle());
+    ui->projectionComboBox->setStyleSheet(style.comboBoxStyle());
+    ui->projectionAxisComboBox->setStyleSheet(style.comboBoxStyle());
+    ui->linkViewportsCheckBox->setStyleSheet(style.checkBoxStyle());
 }
 
 void MainWindow::onOpenFileClicked()
@@ -96,15 +229,180 @@ void MainWindow::onOpenFileClicked()
     m_viewer->loadFile(filePath);
 }
 
+void MainWindow::onOpenSeriesClicked()
+{
+    QString dirPath = QFileDialog::getExistingDirectory(this, "Abrir série DICOM");
+
+    if (dirPath.isEmpty()) {
+        return;
+    }
+
+    m_viewer->loadDirectory(dirPath);
+}
+
+void MainWindow::onRetrieveFromPacsClicked()
+{
+    if (m_retrieveService->isBusy()) {
+        return;
+    }
+
+    bool ok = false;
+    const QString studyUid = QInputDialog::getText(
+        this,
+        "Buscar no PACS",
+        "Study Instance UID:",
+        QLineEdit::Normal,
+        QString(),
+        &ok
+    ).trimmed();
+
+    if (!ok || studyUid.isEmpty()) {
+        return;
+    }
+
+    const auto& config = m_retrieveService->config();
+    ui->statusLabel->setText(QString("Consultando %1@%2:%3...")
+                                 .arg(config.peerAETitle, config.peerHost)
+                                 .arg(config.peerPort));
+    m_retrieveService->retrieveStudy(studyUid);
+}
+
+void MainWindow::onRetrieveFirstImage(const services::DecodedImagePtr& image)
+{
+    // Shown while the rest of the study is still arriving
+    m_retrieveViewer = m_viewer;
+    m_retrieveSeriesUid = image->metadata.seriesInstanceUid;
+    m_viewer->showImage(image);
+}
+
+void MainWindow::onRetrieveSeriesReady(const services::DecodedImagePtr& volume)
+{
+    // The first image's series takes over its viewport; other series of
+    // the study go to viewports that are still empty
+    viewer::DicomViewer* target = nullptr;
+    if (volume->metadata.seriesInstanceUid == m_retrieveSeriesUid && m_retrieveViewer) {
+        target = m_retrieveViewer;
+    } else {
+        for (viewer::DicomViewer* viewer : m_viewports->viewers()) {
+            if (!viewer->hasImage()) {
+                target = viewer;
+                break;
+            }
+        }
+    }
+
+    if (!target) {
+        qInfo() << "PACS retrieve: no free viewport for series" << volume->metadata.seriesInstanceUid;
+        return;
+    }
+    target->showImage(volume);
+}
+
+void MainWindow::onRetrieveProgress(int received, int expected)
+{
+    ui->statusLabel->setText(QString("Recebendo: %1 / %2").arg(received).arg(expected));
+}
+
+void MainWindow::onRetrieveFinished(const services::network::RetrieveStats& stats)
+{
+    ui->statusLabel->setText(QString("%1 imagens em %2 s (%3 img/s)\nPrimeira imagem: %4 ms")
+                                 .arg(stats.imagesReceived)
+                                 .arg(stats.elapsedMs / 1000.0, 0, 'f', 1)
+                                 .arg(stats.imagesPerSecond(), 0, 'f', 1)
+                                 .arg(stats.timeToFirstImageMs));
+}
+
+void MainWindow::onExportClicked()
+{
+    if (m_exportEngine->isBusy()) {
+        return;
+    }
+
+    const QString sourceDir = QFileDialog::getExistingDirectory(this, "Selecionar série DICOM");
+    if (sourceDir.isEmpty()) {
+        return;
+    }
+    const QString outputDir = QFileDialog::getExistingDirectory(this, "Selecionar pasta de destino");
+    if (outputDir.isEmpty()) {
+        return;
+    }
+
+    services::ExportJob job;
+    job.files = services::SeriesLoader::dicomFilesIn(sourceDir);
+    job.outputDir = outputDir;
+    job.presets = models::defaultPresets(m_viewer->hasImage() ? m_viewer->metadata().modality : QString());
+
+    if (job.files.isEmpty()) {
+        onViewerError("Nenhum arquivo DICOM encontrado no diretório");
+        return;
+    }
+
+    ui->statusLabel->setText(QString("Exportando %1 arquivos...").arg(job.files.size()));
+    m_exportEngine->start(job);
+}
+
+void MainWindow::onExportFinished(const services::ExportStats& stats)
+{
+    ui->statusLabel->setText(QString("%1 imagens exportadas em %2 s (%3 img/s)")
+                                 .arg(stats.imagesWritten)
+                                 .arg(stats.elapsedMs / 1000.0, 0, 'f', 1)
+                                 .arg(stats.imagesPerSecond(), 0, 'f', 1));
+    if (stats.failures > 0) {
+        QString message = QString("%1 arquivos não puderam ser exportados").arg(stats.failures);
+        if (!stats.failedPresets.isEmpty()) {
+            message += QString(" (presets: %1)").arg(stats.failedPresets.join(", "));
+        }
+        onViewerError(message);
+    }
+}
+
 void MainWindow::onExitClicked()
 {
     close();
 }
 
-void MainWindow::onImageLoaded(const QString& filePath)
+void MainWindow::onImageLoaded(viewer::DicomViewer* viewer, const QString& filePath)
 {
+    if (m_awaitingFirstImage) {
+        m_awaitingFirstImage = false;
+        const qint64 firstImageMs = m_startup.elapsed();
+        qInfo().noquote() << QString("Startup: first image in %1 ms (window in %2 ms)")
+                                 .arg(firstImageMs).arg(m_timeToWindowMs);
+        ui->statusLabel->setText(QString("Janela: %1 ms\nPrimeira imagem: %2 ms")
+                                     .arg(m_timeToWindowMs).arg(firstImageMs));
+    }
+
+    if (viewer != m_viewer) return;
+
     setWindowTitle(QString("DICOM Viewer - %1").arg(filePath));
+    updateSidePanel();
+}
 
+void MainWindow::onActiveViewerChanged(viewer::DicomViewer* viewer)
+{
+    m_viewer = viewer;
+
+    if (!m_viewer->hasImage()) {
+        setWindowTitle("DICOM Viewer");
+        ui->ajustesWidget->setVisible(false);
+        ui->metadataWidget->setVisible(false);
+        return;
+    }
+
+    setWindowTitle(QString("DICOM Viewer - %1").arg(m_viewer->currentFilePath()));
+    updateSidePanel();
+}
+
+void MainWindow::onLayoutChanged(int index)
+{
+    static const int grids[][2] = {{1, 1}, {1, 2}, {2, 2}, {4, 4}};
+    if (index < 0 || index >= 4) return;
+
+    m_viewports->setGrid(grids[index][0], grids[index][1]);
+}
+
+void MainWindow::updateSidePanel()
+{
     const auto& metadata = m_viewer->metadata();
 
     ui->ajustesWidget->setVisible(true);
@@ -115,13 +413,44 @@ void MainWindow::onImageLoaded(const QString& filePath)
 
     int maxWidth = qMax(10000, static_cast<int>(metadata.windowWidth * 2));
     ui->windowWidthSlider->setMaximum(maxWidth);
-    ui->windowWidthSlider->setValue(static_cast<int>(metadata.windowWidth));
+    ui->windowWidthSlider->setValue(static_cast<int>(m_viewer->windowValue()));
 
     int minLevel = qMin(-5000, static_cast<int>(metadata.windowCenter - metadata.windowWidth));
     int maxLevel = qMax(5000, static_cast<int>(metadata.windowCenter + metadata.windowWidth));
     ui->windowLevelSlider->setMinimum(minLevel);
     ui->windowLevelSlider->setMaximum(maxLevel);
-    ui->windowLevelSlider->setValue(static_cast<int>(metadata.windowCenter));
+    ui->windowLevelSlider->setValue(static_cast<int>(m_viewer->levelValue()));
+
+    const int slices = m_viewer->sliceCount();
+    ui->sliceSlider->blockSignals(true);
+    ui->sliceSlider->setMaximum(qMax(0, slices - 1));
+    ui->sliceSlider->setValue(m_viewer->currentSlice());
+    ui->sliceSlider->blockSignals(false);
+    ui->sliceLabel->setVisible(slices > 1);
+    ui->sliceSlider->setVisible(slices > 1);
+
+    // Projection combo order follows ProjectionMode; axis combo is Axial, Coronal, Sagital
+    const bool projecting = m_viewer->isProjectionActive();
+    const imaging::SlabParams& slab = m_viewer->projection();
+    ui->projectionComboBox->blockSignals(true);
+    ui->projectionAxisComboBox->blockSignals(true);
+    ui->slabThicknessSlider->blockSignals(true);
+    ui->projectionComboBox->setCurrentIndex(projecting ? static_cast<int>(slab.mode) + 1 : 0);
+    ui->projectionAxisComboBox->setCurrentIndex(2 - static_cast<int>(slab.axis));
+    ui->slabThicknessSlider->setValue(slab.thickness);
+    ui->projectionComboBox->blockSignals(false);
+    ui->projectionAxisComboBox->blockSignals(false);
+    ui->slabThicknessSlider->blockSignals(false);
+
+    const bool isVolume = projecting || slices > 1;
+    ui->projectionLabel->setVisible(isVolume);
+    ui->projectionComboBox->setVisible(isVolume);
+    ui->projectionAxisComboBox->setVisible(isVolume);
+    ui->slabThicknessLabel->setVisible(isVolume);
+    ui->slabThicknessSlider->setVisible(isVolume);
+    ui->projectionAxisComboBox->setEnabled(projecting);
+    ui->slabThicknessSlider->setEnabled(projecting);
+    ui->slabThicknessLabel->setText(QString("Espessura do slab: %1").arg(slab.thickness));
 
     ui->windowWidthSlider->blockSignals(false);
     ui->windowLevelSlider->blockSignals(false);
@@ -140,7 +469,11 @@ void MainWindow::onImageLoaded(const QString& filePath)
     QString modalityDisplay = metadata.modality.isEmpty() ? "--" : metadata.modality;
     ui->modalityLabel->setText(QString("Modality: %1").arg(modalityDisplay));
 
-    ui->dimensionsLabel->setText(QString("Size: %1 x %2").arg(metadata.columns).arg(metadata.rows));
+    if (slices > 1) {
+        ui->dimensionsLabel->setText(QString("Size: %1 x %2 x %3").arg(metadata.columns).arg(metadata.rows).arg(slices));
+    } else {
+        ui->dimensionsLabel->setText(QString("Size: %1 x %2").arg(metadata.columns).arg(metadata.rows));
+    }
 
     ui->bitsLabel->setText(QString("Bits: %1 (%2 stored)").arg(metadata.bitsAllocated).arg(metadata.bitsStored));
 }
@@ -163,3 +496,29 @@ void MainWindow::onWindowLevelChanged(int value)
         m_viewer->setWindowLevel(m_viewer->windowValue(), value);
     }
 }
+
+void MainWindow::onSliceSliderChanged(int value)
+{
+    if (m_viewer && m_viewer->hasImage()) {
+        m_viewer->setSlice(value);
+    }
+}
+
+void MainWindow::onProjectionChanged()
+{
+    if (!m_viewer || !m_viewer->hasImage()) {
+        return;
+    }
+
+    const int mode = ui->projectionComboBox->currentIndex();
+    if (mode <= 0) {
+        m_viewer->clearProjection();
+    } else {
+        m_viewer->setProjection(static_cast<imaging::ProjectionMode>(mode - 1),
+                                static_cast<imaging::SlabAxis>(2 - ui->projectionAxisComboBox->currentIndex()),
+                                ui->slabThicknessSlider->value());
+    }
+
+    // Slice range follows the projection axis
+    updateSidePanel();
+}
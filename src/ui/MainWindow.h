@@ -2,9 +2,18 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QLabel>
+#include <QStringList>
+#include <QVector>
 #include <memory>
 #include "../viewer/DicomViewer.h"
+#include "../viewer/ViewportGrid.h"
+#include "../services/ImagingCore.h"
+#include "../services/network/RetrieveService.h"
+#include "../services/ExportEngine.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -20,22 +29,62 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override;
 
+    // Files or series directories from the command line, one per viewport
+    // (4x4 at most), shown as their background decode completes. `startup`
+    // runs since main(); time-to-window and time-to-first-image are reported.
+    static constexpr int MaxStartupPaths = 16;
+    void openAtStartup(const QStringList& paths, const QElapsedTimer& startup);
+
+protected:
+    bool event(QEvent* event) override;
+
 private slots:
     void onOpenFileClicked();
+    void onOpenSeriesClicked();
+    void onRetrieveFromPacsClicked();
+    void onRetrieveFirstImage(const services::DecodedImagePtr& image);
+    void onRetrieveSeriesReady(const services::DecodedImagePtr& volume);
+    void onRetrieveProgress(int received, int expected);
+    void onRetrieveFinished(const services::network::RetrieveStats& stats);
+    void onExportClicked();
+    void onExportFinished(const services::ExportStats& stats);
     void onExitClicked();
-    void onImageLoaded(const QString& filePath);
+    void onImageLoaded(viewer::DicomViewer* viewer, const QString& filePath);
+    void onActiveViewerChanged(viewer::DicomViewer* viewer);
+    void onLayoutChanged(int index);
     void onViewerError(const QString& error);
     void onWindowWidthChanged(int value);
     void onWindowLevelChanged(int value);
+    void onSliceSliderChanged(int value);
+    void onProjectionChanged();
 
 private:
     void setupUi();
     void setupConnections();
     void applyStyles();
     void setupViewer();
+    void setupServices();
+    void updateSidePanel();
+    void onStartupLoaded(const QString& path, const services::DecodedImagePtr& image);
 
     Ui::MainWindow *ui;
-    viewer::DicomViewer* m_viewer = nullptr;
+    viewer::ViewportGrid* m_viewports = nullptr;
+    viewer::DicomViewer* m_viewer = nullptr; // active viewport
+
+    std::shared_ptr<services::ImagingCore> m_core;
+    services::network::RetrieveService* m_retrieveService = nullptr;
+    services::ExportEngine* m_exportEngine = nullptr;
+
+    // Viewport showing the first retrieved image; its series replaces it
+    QPointer<viewer::DicomViewer> m_retrieveViewer;
+    QString m_retrieveSeriesUid;
+
+    QElapsedTimer m_startup;
+    // Normalized command-line path -> viewports still waiting for it
+    QHash<QString, QVector<QPointer<viewer::DicomViewer>>> m_startupTargets;
+    bool m_awaitingWindow = false;
+    bool m_awaitingFirstImage = false;
+    qint64 m_timeToWindowMs = 0;
 };
 
 #endif // MAINWINDOW_H
@@ -122,6 +122,41 @@ QString StyleManager::viewerAreaStyle() const
     )").arg(Colors::background);
 }
 
+QString StyleManager::comboBoxStyle() const
+{
+    return QString(R"(
+        QComboBox {
+            background-color: transparent;
+            color: %1;
+            border: 1px solid %2;
+            border-radius: 6px;
+            font-size: 12px;
+            padding: 8px 12px;
+        }
+        QComboBox:hover {
+            color: %3;
+            border-color: #555555;
+        }
+        QComboBox QAbstractItemView {
+            background-color: %4;
+            color: %3;
+            selection-background-color: %5;
+        }
+    )").arg(Colors::textSecondary, Colors::textMuted, Colors::textPrimary,
+            Colors::backgroundLight, Colors::border);
+}
+
+QString StyleManager::checkBoxStyle() const
+{
+    return QString(R"(
+        QCheckBox {
+            color: %1;
+            font-size: 11px;
+            letter-spacing: 1px;
+        }
+    )").arg(Colors::textSecondary);
+}
+
 void StyleManager::applyGlobalStyle(QWidget* widget) const
 {
     if (widget) {
@@ -29,6 +29,8 @@ public:
     QString labelSubtitleStyle() const;
     QString labelMutedStyle() const;
     QString viewerAreaStyle() const;
+    QString comboBoxStyle() const;
+    QString checkBoxStyle() const;
     
     void applyGlobalStyle(QWidget* widget) const;
 
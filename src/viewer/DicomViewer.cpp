@@ -2,43 +2,48 @@
 
 #include <vtkRenderWindow.h>
 #include <vtkCamera.h>
+#include <vtkCommand.h>
 #include <vtkImageData.h>
 #include <vtkInteractorStyle.h>
 
 #include <QDebug>
-#include <QDir>
-#include <QFileInfo>
+#include <QColor>
+#include <QEvent>
+#include <QPalette>
 
-#include <dcmtk/dcmdata/dcfilefo.h>
-#include <dcmtk/dcmdata/dcdeftag.h>
-#include <dcmtk/dcmdata/dcpixel.h>
-#include <dcmtk/dcmdata/dcpxitem.h>
-#include <dcmtk/dcmjpeg/djdecode.h>
-#include <dcmtk/dcmimgle/dcmimage.h>
-#include <dcmtk/dcmimage/diregist.h>
+#include <algorithm>
+#include <cmath>
+
+#include "services/SeriesLoader.h"
 
 namespace viewer {
 
 DicomViewer::DicomViewer(QWidget *parent)
     : QWidget(parent)
+    , m_core(services::ImagingCore::acquire())
 {
-    DJDecoderRegistration::registerCodecs();
     setupLayout();
     setupVTK();
 }
 
 DicomViewer::~DicomViewer()
 {
-    DJDecoderRegistration::cleanup();
+    if (m_imageViewer && m_renderObserver) {
+        m_imageViewer->GetRenderer()->RemoveObserver(m_renderObserver);
+    }
 }
 
 void DicomViewer::setupLayout()
 {
     QVBoxLayout* layout = new QVBoxLayout(this);
-    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setContentsMargins(1, 1, 1, 1);
     layout->setSpacing(0);
 
+    setAutoFillBackground(true);
+    setHighlighted(false);
+
     m_vtkWidget = new QVTKOpenGLNativeWidget(this);
+    m_vtkWidget->installEventFilter(this);
     layout->addWidget(m_vtkWidget);
 
     setLayout(layout);
@@ -61,6 +66,9 @@ void DicomViewer::configureImageViewer()
 {
     if (!m_imageViewer) {
         m_imageViewer = vtkSmartPointer<vtkImageViewer2>::New();
+        // Pan, zoom, camera resets and resizes all end in a render
+        m_renderObserver = m_imageViewer->GetRenderer()->AddObserver(vtkCommand::StartEvent, this,
+                                                                     &DicomViewer::onRenderStart);
     }
 
     m_renderWindow->RemoveRenderer(m_renderer);
@@ -73,264 +81,375 @@ void DicomViewer::configureImageViewer()
     interactor->SetInteractorStyle(style);
 
     m_renderer = m_imageViewer->GetRenderer();
-}
 
-// --- Helper DRY Template ---
-template<typename T>
-void DicomViewer::copyPixelData(void* dest, const T* source, size_t rows, size_t cols, size_t samplesPerPixel) {
-    T* vtkData = static_cast<T*>(dest);
-    const size_t rowBytes = cols * samplesPerPixel * sizeof(T);
-    
-    // Flip Y axis (DICOM Top-Left -> VTK Bottom-Left)
-    for (size_t y = 0; y < rows; ++y) {
-        const size_t srcRow = rows - 1 - y;
-        memcpy(vtkData + y * cols * samplesPerPixel, 
-               source + srcRow * cols * samplesPerPixel, 
-               rowBytes);
-    }
+    // Input is already mapped to 8 bits: this window/level is the identity,
+    // which vtkImageMapToWindowLevelColors passes through without touching pixels
+    m_imageViewer->SetColorWindow(255.0);
+    m_imageViewer->SetColorLevel(127.5);
 }
 
-// --- SRP: Metadata Extraction ---
-bool DicomViewer::extractMetadata(DcmDataset* dataset) {
-    if (!dataset) return false;
-
-    Uint16 rows = 0, cols = 0;
-    dataset->findAndGetUint16(DCM_Rows, rows);
-    dataset->findAndGetUint16(DCM_Columns, cols);
-
-    if (rows == 0 || cols == 0) return false;
+bool DicomViewer::loadFile(const QString& filePath)
+{
+    if (filePath.isEmpty()) {
+        emit errorOccurred("Caminho do arquivo vazio");
+        return false;
+    }
 
-    Uint16 bitsAllocated = 16, bitsStored = 12, highBit = 11;
-    Uint16 pixelRepresentation = 0;
-    Uint16 samplesPerPixel = 1;
+    try {
+        services::DecodedImagePtr decoded = m_core->loadFile(filePath);
 
-    dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
-    dataset->findAndGetUint16(DCM_BitsStored, bitsStored);
-    dataset->findAndGetUint16(DCM_HighBit, highBit);
-    dataset->findAndGetUint16(DCM_PixelRepresentation, pixelRepresentation);
-    dataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel);
+        if (!decoded) {
+            emit errorOccurred("Falha ao carregar imagem DICOM");
+            return false;
+        }
 
-    m_metadata.rows = rows;
-    m_metadata.columns = cols;
-    m_metadata.bitsAllocated = bitsAllocated;
-    m_metadata.bitsStored = bitsStored;
-    m_metadata.pixelRepresentation = pixelRepresentation;
-    m_metadata.samplesPerPixel = samplesPerPixel;
+        return showImage(decoded);
 
-    OFString strValue;
-    if (dataset->findAndGetOFString(DCM_PatientName, strValue).good()) {
-        m_metadata.patientName = QString::fromUtf8(strValue.c_str());
-    }
-    if (dataset->findAndGetOFString(DCM_PatientID, strValue).good()) {
-        m_metadata.patientId = QString::fromUtf8(strValue.c_str());
+    } catch (const std::exception& e) {
+        emit errorOccurred(QString("Erro ao carregar DICOM: %1").arg(e.what()));
+        return false;
     }
-    if (dataset->findAndGetOFString(DCM_StudyDate, strValue).good()) {
-        m_metadata.studyDate = QString::fromUtf8(strValue.c_str());
+}
+
+bool DicomViewer::showImage(const services::DecodedImagePtr& image)
+{
+    if (!image || !image->image || image->image->GetNumberOfPoints() == 0) {
+        emit errorOccurred("Falha ao carregar imagem DICOM");
+        return false;
     }
-    if (dataset->findAndGetOFString(DCM_Modality, strValue).good()) {
-        m_metadata.modality = QString::fromUtf8(strValue.c_str());
+
+    m_decoded = image;
+    m_metadata = image->metadata;
+    m_imageData = image->image;
+    m_slice = 0;
+    m_window = m_metadata.windowWidth;
+    m_level = m_metadata.windowCenter;
+    m_useDatasetLut = !m_metadata.voiLutData.isEmpty();
+
+    configureImageViewer();
+    m_displayImage = nullptr; // new plane and camera for every series
+    m_roi.reset();
+
+    const QString source = image->sourcePath.isEmpty() ? m_metadata.sopInstanceUid : image->sourcePath;
+    m_currentFilePath = source;
+    m_hasImage = true;
+
+    // Keep the current projection when another series is opened
+    if (m_projectionActive) {
+        int dims[3];
+        m_imageData->GetDimensions(dims);
+        m_slabImage = nullptr;
+        m_slab.position = dims[static_cast<int>(m_slab.axis)] / 2;
+        m_projectionActive = updateProjection();
     }
-    if (dataset->findAndGetOFString(DCM_InstitutionName, strValue).good()) {
-        m_metadata.institutionName = QString::fromUtf8(strValue.c_str());
+    if (!m_projectionActive) {
+        refreshDisplay(false);
     }
 
-    Float64 windowCenter = 0.0, windowWidth = 0.0;
-    if (dataset->findAndGetFloat64(DCM_WindowCenter, windowCenter).good() &&
-        dataset->findAndGetFloat64(DCM_WindowWidth, windowWidth).good()) {
-        m_metadata.windowCenter = windowCenter;
-        m_metadata.windowWidth = windowWidth;
+    emit imageLoaded(source);
+    return true;
+}
+
+bool DicomViewer::loadDirectory(const QString& dirPath)
+{
+    if (dirPath.isEmpty()) {
+        emit errorOccurred("Caminho do diretório vazio");
+        return false;
     }
 
-    OFString pixelSpacing;
-    if (dataset->findAndGetOFString(DCM_PixelSpacing, pixelSpacing, 0).good()) {
-        m_metadata.pixelSpacingY = QString::fromStdString(pixelSpacing.c_str()).toDouble();
+    try {
+        const QStringList files = services::SeriesLoader::dicomFilesIn(dirPath);
+
+        if (files.isEmpty()) {
+            emit errorOccurred("Nenhum arquivo DICOM encontrado no diretório");
+            return false;
+        }
+
+        services::DecodedImagePtr volume = m_core->loadSeries(dirPath);
+        if (!volume) {
+            emit errorOccurred("Falha ao carregar série DICOM");
+            return false;
+        }
+
+        return showImage(volume);
+
+    } catch (const std::exception& e) {
+        emit errorOccurred(QString("Erro ao carregar série DICOM: %1").arg(e.what()));
+        return false;
     }
-    if (dataset->findAndGetOFString(DCM_PixelSpacing, pixelSpacing, 1).good()) {
-        m_metadata.pixelSpacingX = QString::fromStdString(pixelSpacing.c_str()).toDouble();
+}
+
+void DicomViewer::setSlice(int slice)
+{
+    if (!m_hasImage || !m_imageViewer) return;
+
+    const int clamped = qBound(0, slice, sliceCount() - 1);
+    if (clamped == currentSlice()) return;
+
+    if (m_projectionActive) {
+        m_slab.position = clamped;
+        updateProjection();
+    } else {
+        m_slice = clamped;
+        refreshDisplay(true);
     }
 
-    Float64 rescaleSlope = 1.0, rescaleIntercept = 0.0;
-    dataset->findAndGetFloat64(DCM_RescaleSlope, rescaleSlope);
-    dataset->findAndGetFloat64(DCM_RescaleIntercept, rescaleIntercept);
-    m_metadata.rescaleSlope = rescaleSlope;
-    m_metadata.rescaleIntercept = rescaleIntercept;
+    emit sliceChanged(clamped);
+}
 
-    return true;
+int DicomViewer::currentSlice() const
+{
+    if (!m_hasImage) return 0;
+    return m_projectionActive ? m_slab.position : m_slice;
 }
 
-// --- SRP: Image Creation ---
-vtkSmartPointer<vtkImageData> DicomViewer::createVtkImage(DcmDataset* dataset) {
-    vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
-    imageData->SetDimensions(m_metadata.columns, m_metadata.rows, 1);
-    imageData->SetSpacing(m_metadata.pixelSpacingX, m_metadata.pixelSpacingY, 1.0);
-    imageData->SetOrigin(0.0, 0.0, 0.0);
-
-    // Color Images (RGB, YBR, etc.)
-    if (m_metadata.samplesPerPixel > 1) {
-        DicomImage dcmImage(dataset, dataset->getOriginalXfer());
-        if (dcmImage.getStatus() != EIS_Normal) {
-            qWarning() << "DCMTK: Error processing color image";
-            return nullptr;
-        }
+int DicomViewer::sliceCount() const
+{
+    if (!m_hasImage) return 0;
 
-        if (dcmImage.getOutputDataSize(8) == 0) return nullptr;
+    int dims[3];
+    m_imageData->GetDimensions(dims);
+    return dims[m_projectionActive ? static_cast<int>(m_slab.axis) : 2];
+}
 
-        imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
-        const void* rawData = dcmImage.getOutputData(8); // Renders internal buffer
-        
-        copyPixelData(imageData->GetScalarPointer(), 
-                      static_cast<const unsigned char*>(rawData), 
-                      m_metadata.rows, m_metadata.columns, 3);
+void DicomViewer::setWindowLevel(double window, double level)
+{
+    if (!m_hasImage || !m_imageViewer) return;
 
-        if (m_metadata.windowWidth == 0.0) {
-            m_metadata.windowWidth = 255.0;
-            m_metadata.windowCenter = 127.5;
-        }
-    } 
-    // Monochrome Images
-    else {
-        const Uint8* pixelData8 = nullptr;
-        const Uint16* pixelData16 = nullptr;
-        unsigned long pixelCount = 0;
-
-        if (m_metadata.bitsAllocated <= 8) {
-            if (dataset->findAndGetUint8Array(DCM_PixelData, pixelData8, &pixelCount).bad()) return nullptr;
-            
-            imageData->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
-            copyPixelData(imageData->GetScalarPointer(), pixelData8, m_metadata.rows, m_metadata.columns, 1);
-        } else {
-            if (dataset->findAndGetUint16Array(DCM_PixelData, pixelData16, &pixelCount).bad()) return nullptr;
-
-            int scalarType = (m_metadata.pixelRepresentation == 0) ? VTK_UNSIGNED_SHORT : VTK_SHORT;
-            imageData->AllocateScalars(scalarType, 1);
-            
-            if (m_metadata.pixelRepresentation == 0) {
-                 copyPixelData(imageData->GetScalarPointer(), pixelData16, m_metadata.rows, m_metadata.columns, 1);
-            } else {
-                 copyPixelData(imageData->GetScalarPointer(), reinterpret_cast<const short*>(pixelData16), m_metadata.rows, m_metadata.columns, 1);
-            }
-        }
+    // Linked viewports forward every change: skip the remap when nothing moved
+    if (window == m_window && level == m_level) return;
 
-        // Auto Window/Level if missing
-        if (m_metadata.windowWidth == 0.0) {
-            double range[2];
-            imageData->GetScalarRange(range);
-            m_metadata.windowWidth = range[1] - range[0];
-            m_metadata.windowCenter = range[0] + m_metadata.windowWidth / 2.0;
-        }
-    }
+    m_window = window;
+    m_level = level;
+    m_useDatasetLut = false; // an explicit window replaces the dataset VOI LUT
+    refreshDisplay(true);
+
+    emit windowLevelChanged(window, level);
+}
+
+double DicomViewer::windowValue() const
+{
+    return m_hasImage ? m_window : 0.0;
+}
 
-    return imageData;
+double DicomViewer::levelValue() const
+{
+    return m_hasImage ? m_level : 0.0;
 }
 
-vtkSmartPointer<vtkImageData> DicomViewer::loadDicomWithDCMTK(const QString& filePath)
+void DicomViewer::setProjection(imaging::ProjectionMode mode, imaging::SlabAxis axis, int thickness)
 {
-    DcmFileFormat fileFormat;
-    OFCondition status = fileFormat.loadFile(filePath.toStdString().c_str());
+    if (!m_hasImage || !m_imageViewer) return;
+
+    int dims[3];
+    m_imageData->GetDimensions(dims);
 
-    if (status.bad()) {
-        qWarning() << "DCMTK: Failed to load file:" << filePath << "-" << status.text();
-        return nullptr;
+    // Entering an axial slab starts at the slice on screen, other axes at the centre
+    if (!m_projectionActive) {
+        m_slab.position = axis == imaging::SlabAxis::Z ? m_slice : dims[static_cast<int>(axis)] / 2;
+    } else if (m_slab.axis != axis) {
+        m_slab.position = dims[static_cast<int>(axis)] / 2;
     }
 
-    DcmDataset* dataset = fileFormat.getDataset();
-    if (!dataset) {
-        qWarning() << "DCMTK: Invalid dataset";
-        return nullptr;
+    m_slab.mode = mode;
+    m_slab.axis = axis;
+    m_slab.thickness = qMax(1, thickness);
+    m_projectionActive = true;
+
+    if (!updateProjection()) {
+        m_projectionActive = false;
+        emit errorOccurred("Projeção disponível apenas para imagens monocromáticas");
+        return;
     }
 
-    dataset->chooseRepresentation(EXS_LittleEndianExplicit, nullptr);
+    emit sliceChanged(m_slab.position);
+}
+
+void DicomViewer::clearProjection()
+{
+    if (!m_projectionActive) return;
 
-    if (!extractMetadata(dataset)) {
-        qWarning() << "DCMTK: Failed to extract metadata or invalid dimensions";
-        return nullptr;
+    m_projectionActive = false;
+    m_slabImage = nullptr;
+    if (m_slab.axis == imaging::SlabAxis::Z) {
+        m_slice = m_slab.position;
     }
+    refreshDisplay(true);
 
-    return createVtkImage(dataset);
+    emit sliceChanged(m_slice);
 }
 
-bool DicomViewer::loadFile(const QString& filePath)
+bool DicomViewer::updateProjection()
 {
-    if (filePath.isEmpty()) {
-        emit errorOccurred("Caminho do arquivo vazio");
-        return false;
+    // The previous slab image is rewritten in place unless the plane changed
+    vtkSmartPointer<vtkImageData> projected =
+        imaging::projectSlab(m_imageData, m_slab, m_core->threadPool(), m_slabImage);
+    if (!projected) return false;
+
+    m_slabImage = projected;
+    if (m_roi && m_roi->image() == m_slabImage) {
+        m_roi->invalidate();
     }
+    refreshDisplay(true);
+    return true;
+}
 
-    try {
-        m_imageData = loadDicomWithDCMTK(filePath);
+void DicomViewer::refreshDisplay(bool visibleOnly)
+{
+    vtkImageData* source = m_projectionActive ? m_slabImage.Get() : m_imageData.Get();
+    const int slice = m_projectionActive ? 0 : m_slice;
+    if (!source) return;
+
+    int dims[3];
+    double spacing[3];
+    double origin[3];
+    source->GetDimensions(dims);
+    source->GetSpacing(spacing);
+    source->GetOrigin(origin);
+    const int components = source->GetNumberOfScalarComponents();
+
+    // The display plane follows the source plane; a new plane resets the camera
+    bool newPlane = !m_displayImage;
+    if (!newPlane) {
+        int displayDims[3];
+        double displaySpacing[3];
+        m_displayImage->GetDimensions(displayDims);
+        m_displayImage->GetSpacing(displaySpacing);
+        newPlane = displayDims[0] != dims[0] || displayDims[1] != dims[1] ||
+                   displaySpacing[0] != spacing[0] || displaySpacing[1] != spacing[1] ||
+                   m_displayImage->GetNumberOfScalarComponents() != components;
+    }
+    if (newPlane) {
+        m_displayImage = vtkSmartPointer<vtkImageData>::New();
+        m_displayImage->SetDimensions(dims[0], dims[1], 1);
+        m_displayImage->SetSpacing(spacing[0], spacing[1], 1.0);
+        m_displayImage->SetOrigin(origin[0], origin[1], 0.0);
+        m_displayImage->AllocateScalars(VTK_UNSIGNED_CHAR, components);
+    }
 
-        if (!m_imageData || m_imageData->GetNumberOfPoints() == 0) {
-            emit errorOccurred("Falha ao carregar imagem DICOM");
-            return false;
-        }
+    m_lut.update(imaging::VoiSettings::fromMetadata(m_metadata, m_window, m_level, m_useDatasetLut),
+                 source->GetScalarType());
 
-        configureImageViewer();
-        m_imageViewer->SetInputData(m_imageData);
-        m_imageViewer->SetColorWindow(m_metadata.windowWidth);
-        m_imageViewer->SetColorLevel(m_metadata.windowCenter);
+    // Only what the camera shows is remapped; the rest is filled in by
+    // onRenderStart() once a camera change uncovers it
+    int region[4] = {0, dims[0] - 1, 0, dims[1] - 1};
+    if (visibleOnly && !newPlane) {
+        int visible[4];
+        if (visibleRegion(visible)) {
+            std::copy(visible, visible + 4, region);
+        }
+    }
+    mapDisplay(source, slice, region);
 
+    if (newPlane || m_imageViewer->GetInput() != m_displayImage) {
+        m_imageViewer->SetInputData(m_displayImage);
+        m_imageViewer->SetSlice(0);
         m_imageViewer->Render();
         m_imageViewer->GetRenderer()->ResetCamera();
-        m_imageViewer->Render();
-
-        m_currentFilePath = filePath;
-        m_hasImage = true;
-
-        emit imageLoaded(filePath);
-        return true;
-
-    } catch (const std::exception& e) {
-        emit errorOccurred(QString("Erro ao carregar DICOM: %1").arg(e.what()));
-        return false;
     }
+    m_imageViewer->Render();
 }
 
-bool DicomViewer::loadDirectory(const QString& dirPath)
+void DicomViewer::mapDisplay(vtkImageData* source, int slice, const int region[4])
 {
-    if (dirPath.isEmpty()) {
-        emit errorOccurred("Caminho do diretório vazio");
-        return false;
-    }
+    int dims[3];
+    m_displayImage->GetDimensions(dims);
+    std::copy(region, region + 4, m_mappedRegion);
+    m_displayPartial = region[0] > 0 || region[1] < dims[0] - 1 || region[2] > 0 || region[3] < dims[1] - 1;
 
-    try {
-        QDir dir(dirPath);
-        QStringList filters;
-        filters << "*.dcm" << "*.DCM" << "*.dicom" << "*.DICOM";
-        QStringList files = dir.entryList(filters, QDir::Files, QDir::Name);
+    m_lut.mapRegion(source, slice, region, m_displayImage, m_core->threadPool());
+    m_displayImage->Modified();
+}
 
-        if (files.isEmpty()) {
-            emit errorOccurred("Nenhum arquivo DICOM encontrado no diretório");
-            return false;
-        }
+void DicomViewer::onRenderStart()
+{
+    if (!m_displayPartial || !m_displayImage) return;
 
-        QString firstFile = dir.absoluteFilePath(files.first());
-        return loadFile(firstFile);
+    vtkImageData* source = m_projectionActive ? m_slabImage.Get() : m_imageData.Get();
+    const int slice = m_projectionActive ? 0 : m_slice;
+    if (!source) return;
 
-    } catch (const std::exception& e) {
-        emit errorOccurred(QString("Erro ao carregar série DICOM: %1").arg(e.what()));
-        return false;
+    int visible[4];
+    if (visibleRegion(visible) &&
+        visible[0] >= m_mappedRegion[0] && visible[1] <= m_mappedRegion[1] &&
+        visible[2] >= m_mappedRegion[2] && visible[3] <= m_mappedRegion[3]) {
+        return;
     }
+
+    // The view now reaches pixels the last remap skipped: map the whole
+    // plane once, before this render draws it, so later pans cost nothing
+    int dims[3];
+    m_displayImage->GetDimensions(dims);
+    const int region[4] = {0, dims[0] - 1, 0, dims[1] - 1};
+    mapDisplay(source, slice, region);
 }
 
-void DicomViewer::setWindowLevel(double window, double level)
+bool DicomViewer::visibleRegion(int region[4]) const
 {
-    if (!m_hasImage || !m_imageViewer) return;
+    vtkRenderer* renderer = m_imageViewer->GetRenderer();
+    vtkCamera* camera = renderer->GetActiveCamera();
+    const int* size = renderer->GetSize();
+    if (!camera->GetParallelProjection() || size[0] <= 0 || size[1] <= 0) return false;
+
+    // vtkImageViewer2 looks down -Z with +Y up: the view is an axis-aligned box
+    const double halfHeight = camera->GetParallelScale();
+    const double halfWidth = halfHeight * size[0] / size[1];
+    double focal[3];
+    double spacing[3];
+    double origin[3];
+    int dims[3];
+    camera->GetFocalPoint(focal);
+    m_displayImage->GetSpacing(spacing);
+    m_displayImage->GetOrigin(origin);
+    m_displayImage->GetDimensions(dims);
+
+    region[0] = qMax(0, static_cast<int>(std::floor((focal[0] - halfWidth - origin[0]) / spacing[0])));
+    region[1] = qMin(dims[0] - 1, static_cast<int>(std::ceil((focal[0] + halfWidth - origin[0]) / spacing[0])));
+    region[2] = qMax(0, static_cast<int>(std::floor((focal[1] - halfHeight - origin[1]) / spacing[1])));
+    region[3] = qMin(dims[1] - 1, static_cast<int>(std::ceil((focal[1] + halfHeight - origin[1]) / spacing[1])));
+    return region[0] <= region[1] && region[2] <= region[3];
+}
 
-    m_imageViewer->SetColorWindow(window);
-    m_imageViewer->SetColorLevel(level);
-    m_imageViewer->Render();
+imaging::RoiStatistics* DicomViewer::roiStatistics(int& slice)
+{
+    if (!m_hasImage) return nullptr;
 
-    emit windowLevelChanged(window, level);
+    vtkImageData* source = m_projectionActive ? m_slabImage.Get() : m_imageData.Get();
+    slice = m_projectionActive ? 0 : m_slice;
+    if (!source) return nullptr;
+
+    if (!m_roi || m_roi->image() != source) {
+        // Slab planes carry their own in-plane spacing (e.g. coronal: x and z)
+        double spacing[3] = {m_metadata.pixelSpacingX, m_metadata.pixelSpacingY, 1.0};
+        if (m_projectionActive) {
+            source->GetSpacing(spacing);
+        }
+        m_roi = std::make_unique<imaging::RoiStatistics>(source, m_metadata.rescaleSlope, m_metadata.rescaleIntercept,
+                                                         spacing[0], spacing[1], m_core->threadPool());
+    }
+    return m_roi.get();
 }
 
-double DicomViewer::windowValue() const
+imaging::RoiStats DicomViewer::measureRectangle(const QRect& pixels)
 {
-    return (m_hasImage && m_imageViewer) ? m_imageViewer->GetColorWindow() : 0.0;
+    int slice = 0;
+    imaging::RoiStatistics* roi = roiStatistics(slice);
+    return roi ? roi->rectangle(slice, pixels.left(), pixels.top(), pixels.right(), pixels.bottom())
+               : imaging::RoiStats();
 }
 
-double DicomViewer::levelValue() const
+imaging::RoiStats DicomViewer::measureEllipse(const QRectF& bounds)
 {
-    return (m_hasImage && m_imageViewer) ? m_imageViewer->GetColorLevel() : 0.0;
+    int slice = 0;
+    imaging::RoiStatistics* roi = roiStatistics(slice);
+    return roi ? roi->ellipse(slice, bounds) : imaging::RoiStats();
+}
+
+imaging::RoiStats DicomViewer::measurePolygon(const QPolygonF& polygon)
+{
+    int slice = 0;
+    imaging::RoiStatistics* roi = roiStatistics(slice);
+    return roi ? roi->polygon(slice, polygon) : imaging::RoiStats();
 }
 
 bool DicomViewer::hasImage() const
@@ -343,4 +462,20 @@ QString DicomViewer::currentFilePath() const
     return m_currentFilePath;
 }
 
+void DicomViewer::setHighlighted(bool highlighted)
+{
+    QPalette pal = palette();
+    pal.setColor(QPalette::Window, highlighted ? QColor("#666666") : QColor("#0a0a0a"));
+    setPalette(pal);
+}
+
+bool DicomViewer::eventFilter(QObject* watched, QEvent* event)
+{
+    if (watched == m_vtkWidget &&
+        (event->type() == QEvent::MouseButtonPress || event->type() == QEvent::FocusIn)) {
+        emit activated(this);
+    }
+    return QWidget::eventFilter(watched, event);
+}
+
 }
@@ -3,8 +3,11 @@
 
 #include <QWidget>
 #include <QVBoxLayout>
+#include <QRect>
 #include <QString>
 
+#include <memory>
+
 // VTK includes
 #include <vtkSmartPointer.h>
 #include <vtkRenderer.h>
@@ -15,30 +18,20 @@
 #include <vtkInteractorStyleImage.h>
 #include <QVTKOpenGLNativeWidget.h>
 
-class DcmDataset;
+#include "imaging/RoiStatistics.h"
+#include "imaging/SlabProjector.h"
+#include "imaging/WindowLevelLut.h"
+#include "models/DicomMetadata.h"
+#include "services/DicomDecoder.h"
+#include "services/ImagingCore.h"
 
 namespace viewer {
 
-struct DicomMetadata {
-    QString patientName;
-    QString patientId;
-    QString studyDate;
-    QString modality;
-    QString institutionName;
-    int rows = 0;
-    int columns = 0;
-    int bitsAllocated = 0;
-    int bitsStored = 0;
-    int pixelRepresentation = 0;
-    int samplesPerPixel = 1;
-    double windowCenter = 0.0;
-    double windowWidth = 0.0;
-    double pixelSpacingX = 1.0;
-    double pixelSpacingY = 1.0;
-    double rescaleSlope = 1.0;
-    double rescaleIntercept = 0.0;
-};
+using models::DicomMetadata;
 
+// Lightweight viewport: owns only its render window. Decoding, the worker
+// pool and the pixel cache live in the shared ImagingCore, so many viewers
+// can show the same series without duplicating memory.
 class DicomViewer : public QWidget
 {
     Q_OBJECT
@@ -50,32 +43,61 @@ public:
     bool loadFile(const QString& filePath);
     bool loadDirectory(const QString& dirPath);
 
+    // Displays an already decoded instance (e.g. streamed from the network)
+    bool showImage(const services::DecodedImagePtr& image);
+
+    void setSlice(int slice);
+    int currentSlice() const;
+    int sliceCount() const;
+
     void setWindowLevel(double window, double level);
     double windowValue() const;
     double levelValue() const;
 
+    // Thick-slab projection of the loaded volume. While active, the slice
+    // API moves the slab centre along the projection axis.
+    void setProjection(imaging::ProjectionMode mode, imaging::SlabAxis axis, int thickness);
+    void clearProjection();
+    bool isProjectionActive() const { return m_projectionActive; }
+    const imaging::SlabParams& projection() const { return m_slab; }
+
+    // ROI statistics on the plane on screen (slice or slab) in modality
+    // units; coordinates are vtkImageData pixel indices. Cheap enough to
+    // call on every mouse move while a shape is dragged.
+    imaging::RoiStats measureRectangle(const QRect& pixels);
+    imaging::RoiStats measureEllipse(const QRectF& bounds);
+    imaging::RoiStats measurePolygon(const QPolygonF& polygon);
+
     bool hasImage() const;
     QString currentFilePath() const;
 
     const DicomMetadata& metadata() const { return m_metadata; }
 
+    // Frame used by ViewportGrid to mark the active viewport
+    void setHighlighted(bool highlighted);
+
 signals:
     void imageLoaded(const QString& filePath);
     void windowLevelChanged(double window, double level);
+    void sliceChanged(int slice);
     void errorOccurred(const QString& error);
+    void activated(viewer::DicomViewer* viewer);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
 
 private:
     void setupLayout();
     void setupVTK();
     void configureImageViewer();
-    vtkSmartPointer<vtkImageData> loadDicomWithDCMTK(const QString& filePath);
+    bool updateProjection();
+    void refreshDisplay(bool visibleOnly);
+    void mapDisplay(vtkImageData* source, int slice, const int region[4]);
+    void onRenderStart();
+    bool visibleRegion(int region[4]) const;
+    imaging::RoiStatistics* roiStatistics(int& slice);
 
-    // Helpers para SOLID (SRP) e DRY
-    bool extractMetadata(DcmDataset* dataset);
-    vtkSmartPointer<vtkImageData> createVtkImage(DcmDataset* dataset);
-    
-    template<typename T>
-    void copyPixelData(void* dest, const T* source, size_t rows, size_t cols, size_t samplesPerPixel);
+    std::shared_ptr<services::ImagingCore> m_core;
 
     QVTKOpenGLNativeWidget* m_vtkWidget = nullptr;
 
@@ -84,6 +106,25 @@ private:
     vtkSmartPointer<vtkInteractorStyleImage> m_interactorStyle;
     vtkSmartPointer<vtkImageViewer2> m_imageViewer;
     vtkSmartPointer<vtkImageData> m_imageData;
+    services::DecodedImagePtr m_decoded;
+    int m_slice = 0;
+
+    // W/L runs on the CPU through a lookup table into an 8-bit display
+    // plane; vtkImageViewer2 only passes it through
+    double m_window = 0.0;
+    double m_level = 0.0;
+    bool m_useDatasetLut = false;
+    imaging::WindowLevelLut m_lut;
+    vtkSmartPointer<vtkImageData> m_displayImage;
+    bool m_displayPartial = false;
+    int m_mappedRegion[4] = {0, -1, 0, -1}; // x0, x1, y0, y1 of the last remap
+    unsigned long m_renderObserver = 0;
+
+    bool m_projectionActive = false;
+    imaging::SlabParams m_slab;
+    vtkSmartPointer<vtkImageData> m_slabImage;
+
+    std::unique_ptr<imaging::RoiStatistics> m_roi;
 
     QString m_currentFilePath;
     bool m_hasImage = false;
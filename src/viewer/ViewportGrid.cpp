@@ -0,0 +1,114 @@
+#include "ViewportGrid.h"
+
+#include <utility>
+
+namespace viewer {
+
+ViewportGrid::ViewportGrid(QWidget *parent)
+    : QWidget(parent)
+{
+    m_layout = new QGridLayout(this);
+    m_layout->setContentsMargins(0, 0, 0, 0);
+    m_layout->setSpacing(2);
+    setLayout(m_layout);
+
+    setGrid(1, 1);
+}
+
+DicomViewer* ViewportGrid::createViewer()
+{
+    DicomViewer* viewer = new DicomViewer(this);
+
+    connect(viewer, &DicomViewer::activated,
+            this, &ViewportGrid::setActiveViewer);
+    connect(viewer, &DicomViewer::imageLoaded, this, [this, viewer](const QString& filePath) {
+        m_lastSlice[viewer] = viewer->currentSlice();
+        emit imageLoaded(viewer, filePath);
+    });
+    connect(viewer, &DicomViewer::errorOccurred,
+            this, &ViewportGrid::errorOccurred);
+    connect(viewer, &DicomViewer::sliceChanged, this, [this, viewer](int slice) {
+        onSliceChanged(viewer, slice);
+    });
+    connect(viewer, &DicomViewer::windowLevelChanged, this, [this, viewer](double window, double level) {
+        onWindowLevelChanged(viewer, window, level);
+    });
+
+    return viewer;
+}
+
+void ViewportGrid::setGrid(int rows, int columns)
+{
+    rows = qMax(1, rows);
+    columns = qMax(1, columns);
+    if (rows == m_rows && columns == m_columns) return;
+
+    const int count = rows * columns;
+
+    // Keep existing viewports (and their images), drop or add at the end
+    while (m_viewers.size() > count) {
+        DicomViewer* viewer = m_viewers.takeLast();
+        m_lastSlice.remove(viewer);
+        m_layout->removeWidget(viewer);
+        viewer->deleteLater();
+    }
+    while (m_viewers.size() < count) {
+        m_viewers.append(createViewer());
+    }
+
+    for (int i = 0; i < count; ++i) {
+        m_layout->removeWidget(m_viewers[i]);
+        m_layout->addWidget(m_viewers[i], i / columns, i % columns);
+    }
+
+    m_rows = rows;
+    m_columns = columns;
+
+    setActiveViewer(m_viewers.contains(m_active) ? m_active : m_viewers.first());
+}
+
+void ViewportGrid::setActiveViewer(DicomViewer* viewer)
+{
+    for (DicomViewer* v : std::as_const(m_viewers)) {
+        v->setHighlighted(m_viewers.size() > 1 && v == viewer);
+    }
+
+    if (viewer == m_active) return;
+
+    m_active = viewer;
+    emit activeViewerChanged(viewer);
+}
+
+void ViewportGrid::onSliceChanged(DicomViewer* source, int slice)
+{
+    const int delta = slice - m_lastSlice.value(source, slice);
+    m_lastSlice[source] = slice;
+
+    if (!m_linked || m_syncing || delta == 0) return;
+
+    // Relative scrolling keeps prior/current series aligned at whatever
+    // offset the reader set up. setSlice() is a no-op for viewports that
+    // are already at their limit, so those are not re-rendered.
+    m_syncing = true;
+    for (DicomViewer* viewer : std::as_const(m_viewers)) {
+        if (viewer != source && viewer->hasImage()) {
+            viewer->setSlice(viewer->currentSlice() + delta);
+        }
+    }
+    m_syncing = false;
+}
+
+void ViewportGrid::onWindowLevelChanged(DicomViewer* source, double window, double level)
+{
+    if (!m_linked || m_syncing) return;
+
+    m_syncing = true;
+    for (DicomViewer* viewer : std::as_const(m_viewers)) {
+        if (viewer != source && viewer->hasImage()) {
+            viewer->setWindowLevel(window, level);
+        }
+    }
+    m_syncing = false;
+}
+
+} // namespace viewer
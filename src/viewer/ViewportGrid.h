@@ -0,0 +1,59 @@
+#ifndef VIEWPORTGRID_H
+#define VIEWPORTGRID_H
+
+#include <QGridLayout>
+#include <QHash>
+#include <QVector>
+#include <QWidget>
+
+#include "DicomViewer.h"
+
+namespace viewer {
+
+// Arranges DicomViewer viewports in a rows x columns layout (1x1, 1x2, 2x2,
+// 4x4...) for prior/current comparison. All viewports share one
+// ImagingCore. When linked, scrolling and window/level of the viewport
+// being driven are mirrored to the others; viewports whose state does not
+// actually change are not re-rendered.
+class ViewportGrid : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ViewportGrid(QWidget *parent = nullptr);
+
+    void setGrid(int rows, int columns);
+    int rows() const { return m_rows; }
+    int columns() const { return m_columns; }
+
+    DicomViewer* activeViewer() const { return m_active; }
+    const QVector<DicomViewer*>& viewers() const { return m_viewers; }
+
+    void setLinked(bool linked) { m_linked = linked; }
+    bool isLinked() const { return m_linked; }
+
+signals:
+    void activeViewerChanged(viewer::DicomViewer* viewer);
+    void imageLoaded(viewer::DicomViewer* viewer, const QString& filePath);
+    void errorOccurred(const QString& error);
+
+private:
+    DicomViewer* createViewer();
+    void setActiveViewer(DicomViewer* viewer);
+    void onSliceChanged(DicomViewer* source, int slice);
+    void onWindowLevelChanged(DicomViewer* source, double window, double level);
+
+    QGridLayout* m_layout = nullptr;
+    QVector<DicomViewer*> m_viewers;
+    QHash<DicomViewer*, int> m_lastSlice;
+    DicomViewer* m_active = nullptr;
+
+    int m_rows = 0;
+    int m_columns = 0;
+    bool m_linked = false;
+    bool m_syncing = false;
+};
+
+} // namespace viewer
+
+#endif // VIEWPORTGRID_H
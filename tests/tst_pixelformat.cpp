@@ -0,0 +1,264 @@
+// Unit tests for the fused unpack kernels and the histogram convention.
+// Needs Qt Core/Test and the VTK data model only (no widgets, no DCMTK).
+
+#include "imaging/Histogram.h"
+#include "imaging/PixelFormat.h"
+
+#include <QtTest>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace imaging;
+
+namespace {
+
+PixelFormat monoFormat(int bitsAllocated, int bitsStored, int highBit, bool isSigned)
+{
+    PixelFormat format;
+    format.bitsAllocated = bitsAllocated;
+    format.bitsStored = bitsStored;
+    format.highBit = highBit;
+    format.isSigned = isSigned;
+    return format;
+}
+
+PixelFormat colorFormat(Photometric photometric, int planarConfiguration)
+{
+    PixelFormat format;
+    format.bitsAllocated = 8;
+    format.bitsStored = 8;
+    format.highBit = 7;
+    format.samplesPerPixel = 3;
+    format.planarConfiguration = planarConfiguration;
+    format.photometric = photometric;
+    return format;
+}
+
+// PS3.3 C.7.6.3.1.2 in floating point, rounded and clamped
+int ybrToRgb(int y, int cb, int cr, int channel)
+{
+    const double value = channel == 0 ? y + 1.402 * (cr - 128)
+                       : channel == 1 ? y - 0.344136 * (cb - 128) - 0.714136 * (cr - 128)
+                                      : y + 1.772 * (cb - 128);
+    return std::min(255, std::max(0, static_cast<int>(std::lround(value))));
+}
+
+} // namespace
+
+class PixelFormatTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void masksBitsOutsideHighBit();
+    void signExtendsTwelveBitValues();
+    void swapsBigEndianWords();
+    void foldsRescaleIntoUnpack();
+    void rescaleBoundsFitInt16();
+    void flipsRowsBottomUp();
+    void convertsYbrFullToRgb();
+    void interleavesPlanarColor();
+    void valueCountsMatchComputedHistogram();
+};
+
+void PixelFormatTest::masksBitsOutsideHighBit()
+{
+    // 12 stored bits at [13..2]: overlay bits above and padding below must go
+    const PixelFormat format = monoFormat(16, 12, 13, false);
+    const quint16 source[4] = {
+        static_cast<quint16>((0x000 << 2) | 0xc003),
+        static_cast<quint16>((0x123 << 2) | 0x8001),
+        static_cast<quint16>((0xfff << 2) | 0x4002),
+        static_cast<quint16>(0x7ff << 2),
+    };
+    quint16 dest[4] = {};
+    UnpackResult result;
+    QVERIFY(unpackPixels(format, source, 1, 4, false, 0, dest, result));
+
+    QCOMPARE(dest[0], quint16(0x000));
+    QCOMPARE(dest[1], quint16(0x123));
+    QCOMPARE(dest[2], quint16(0xfff));
+    QCOMPARE(dest[3], quint16(0x7ff));
+    QCOMPARE(result.minValue, 0.0);
+    QCOMPARE(result.maxValue, 4095.0);
+}
+
+void PixelFormatTest::signExtendsTwelveBitValues()
+{
+    // Bits 15..12 are set (overlay or sign-filled) and must not leak in
+    const PixelFormat format = monoFormat(16, 12, 11, true);
+    const quint16 source[5] = {0xffff, 0xf800, 0xf7ff, 0x0800, 0x07ff};
+    qint16 dest[5] = {};
+    UnpackResult result;
+    QVERIFY(unpackPixels(format, source, 1, 5, false, 0, dest, result));
+
+    QCOMPARE(dest[0], qint16(-1));
+    QCOMPARE(dest[1], qint16(-2048));
+    QCOMPARE(dest[2], qint16(2047));
+    QCOMPARE(dest[3], qint16(-2048));
+    QCOMPARE(dest[4], qint16(2047));
+    QCOMPARE(result.minValue, -2048.0);
+    QCOMPARE(result.maxValue, 2047.0);
+}
+
+void PixelFormatTest::swapsBigEndianWords()
+{
+    PixelFormat format = monoFormat(16, 16, 15, true);
+    format.bigEndian = true;
+    const quint8 bytes[4] = {0xfc, 0x01, 0x80, 0x00}; // 0xfc01, 0x8000
+    quint16 source[2];
+    std::memcpy(source, bytes, sizeof(source));
+    qint16 dest[2] = {};
+    UnpackResult result;
+    QVERIFY(unpackPixels(format, source, 1, 2, false, 0, dest, result));
+
+    QCOMPARE(dest[0], qint16(-1023));
+    QCOMPARE(dest[1], qint16(-32768));
+}
+
+void PixelFormatTest::foldsRescaleIntoUnpack()
+{
+    const PixelFormat format = monoFormat(16, 12, 11, false);
+    QVERIFY(canRescaleToInt16(format, 1.0, -1024.0));
+    QCOMPARE(outputScalarType(format, true), VTK_SHORT);
+
+    const quint16 source[3] = {0, 1024, 4095};
+    qint16 dest[3] = {};
+    UnpackResult result;
+    QVERIFY(unpackPixels(format, source, 1, 3, true, -1024, dest, result));
+
+    QCOMPARE(dest[0], qint16(-1024));
+    QCOMPARE(dest[1], qint16(0));
+    QCOMPARE(dest[2], qint16(3071));
+    QCOMPARE(result.counts.firstValue, -1024);
+    QCOMPARE(static_cast<int>(result.counts.counts.size()), 4096);
+}
+
+void PixelFormatTest::rescaleBoundsFitInt16()
+{
+    const PixelFormat unsigned12 = monoFormat(16, 12, 11, false);
+    const PixelFormat unsigned16 = monoFormat(16, 16, 15, false);
+    const PixelFormat signed16 = monoFormat(16, 16, 15, true);
+
+    QVERIFY(canRescaleToInt16(unsigned12, 1.0, -1024.0));
+    QVERIFY(canRescaleToInt16(unsigned12, 1.0, 28672.0));   // 4095 + 28672 == 32767
+    QVERIFY(!canRescaleToInt16(unsigned12, 1.0, 28673.0));
+    QVERIFY(canRescaleToInt16(unsigned16, 1.0, -32768.0));  // [-32768, 32767]
+    QVERIFY(!canRescaleToInt16(unsigned16, 1.0, -1024.0));  // 65535 - 1024 overflows
+    QVERIFY(!canRescaleToInt16(signed16, 1.0, -1.0));       // -32768 - 1 underflows
+    QVERIFY(!canRescaleToInt16(signed16, 1.0, 0.0));        // nothing to fold
+    QVERIFY(!canRescaleToInt16(unsigned12, 2.0, -1024.0));
+    QVERIFY(!canRescaleToInt16(unsigned12, 1.0, -1024.5));
+    QVERIFY(!canRescaleToInt16(colorFormat(Photometric::Rgb, 0), 1.0, -1024.0));
+}
+
+void PixelFormatTest::flipsRowsBottomUp()
+{
+    const PixelFormat format = monoFormat(8, 8, 7, false);
+    const quint8 source[6] = {1, 2, 3, 4, 5, 6}; // 3 rows x 2 columns, top row first
+    quint8 dest[6] = {};
+    UnpackResult result;
+    QVERIFY(unpackPixels(format, source, 3, 2, false, 0, dest, result));
+
+    const quint8 expected[6] = {5, 6, 3, 4, 1, 2};
+    QVERIFY(std::equal(dest, dest + 6, expected));
+}
+
+void PixelFormatTest::convertsYbrFullToRgb()
+{
+    // Grey axis, primaries and saturating corners
+    const int samples[][3] = {
+        {128, 128, 128}, {0, 128, 128}, {255, 128, 128}, {76, 85, 255}, {150, 44, 21},
+        {29, 255, 107},  {255, 0, 0},   {0, 255, 255},   {255, 255, 255}, {90, 200, 60},
+    };
+    const int count = static_cast<int>(sizeof(samples) / sizeof(samples[0]));
+
+    std::vector<quint8> source;
+    for (const auto& sample : samples) {
+        source.insert(source.end(), sample, sample + 3);
+    }
+    std::vector<quint8> dest(source.size());
+    UnpackResult result;
+    QVERIFY(unpackPixels(colorFormat(Photometric::YbrFull, 0), source.data(), 1, count, false, 0,
+                         dest.data(), result));
+
+    QCOMPARE(dest[0], quint8(128));
+    QCOMPARE(dest[1], quint8(128));
+    QCOMPARE(dest[2], quint8(128));
+    for (int i = 0; i < count; ++i) {
+        for (int channel = 0; channel < 3; ++channel) {
+            const int expected = ybrToRgb(samples[i][0], samples[i][1], samples[i][2], channel);
+            QVERIFY2(std::abs(dest[i * 3 + channel] - expected) <= 1,
+                     qPrintable(QString("sample %1 channel %2: %3, expected %4")
+                                    .arg(i).arg(channel).arg(dest[i * 3 + channel]).arg(expected)));
+        }
+    }
+}
+
+void PixelFormatTest::interleavesPlanarColor()
+{
+    // 2 rows x 2 columns, R plane then G then B
+    const quint8 source[12] = {10, 11, 12, 13, 20, 21, 22, 23, 30, 31, 32, 33};
+    quint8 dest[12] = {};
+    UnpackResult result;
+    QVERIFY(unpackPixels(colorFormat(Photometric::Rgb, 1), source, 2, 2, false, 0, dest, result));
+
+    const quint8 expected[12] = {12, 22, 32, 13, 23, 33, 10, 20, 30, 11, 21, 31};
+    QVERIFY(std::equal(dest, dest + 12, expected));
+}
+
+void PixelFormatTest::valueCountsMatchComputedHistogram()
+{
+    // Frames with different ranges: merged and binned counts must equal a
+    // histogram computed over the assembled volume
+    const int columns = 37;
+    const int rows = 29;
+    const int frames = 6;
+    const PixelFormat format = monoFormat(16, 12, 11, false);
+
+    auto volume = vtkSmartPointer<vtkImageData>::New();
+    volume->SetDimensions(columns, rows, frames);
+    volume->AllocateScalars(VTK_SHORT, 1);
+    auto* dest = static_cast<qint16*>(volume->GetScalarPointer());
+
+    std::mt19937 random(7);
+    std::vector<models::ValueCounts> counts(frames);
+    QVector<const models::ValueCounts*> parts;
+    for (int z = 0; z < frames; ++z) {
+        const int low = static_cast<int>(random() % 500);
+        const int width = 50 + static_cast<int>(random() % (z == 3 ? 3500 : 300));
+        std::vector<quint16> source(rows * columns);
+        for (quint16& value : source) {
+            value = static_cast<quint16>(low + random() % width);
+        }
+
+        UnpackResult result;
+        QVERIFY(unpackPixels(format, source.data(), rows, columns, true, -1024,
+                             dest + static_cast<std::size_t>(z) * rows * columns, result));
+        QCOMPARE(result.counts.firstValue, static_cast<int>(result.minValue));
+        QCOMPARE(static_cast<int>(result.counts.counts.size()), static_cast<int>(result.maxValue - result.minValue) + 1);
+        counts[z] = result.counts;
+        parts.append(&counts[z]);
+    }
+
+    models::ValueCounts total;
+    QVERIFY(mergeValueCounts(parts, total));
+    const models::Histogram merged = binValueCounts(total);
+    const models::Histogram computed = computeHistogram(volume, nullptr);
+
+    QCOMPARE(merged.minValue, computed.minValue);
+    QCOMPARE(merged.maxValue, computed.maxValue);
+    QCOMPARE(merged.bins, computed.bins);
+}
+
+QTEST_APPLESS_MAIN(PixelFormatTest)
+
+#include "tst_pixelformat.moc"
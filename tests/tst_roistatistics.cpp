@@ -0,0 +1,324 @@
+// Unit tests for the summed-area-table ROI statistics and the span
+// rasterisers, checked against brute-force scans of the same pixels.
+// Needs Qt Core/Gui/Test and the VTK data model only (no widgets, no DCMTK).
+
+#include "imaging/RoiStatistics.h"
+
+#include <QtTest>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+#include <type_traits>
+#include <utility>
+
+using namespace imaging;
+
+namespace {
+
+constexpr int Width = 70;  // not a multiple of the 32-pixel min/max blocks
+constexpr int Height = 45;
+constexpr int Slices = 3;
+
+template<typename T>
+vtkSmartPointer<vtkImageData> randomImage(int scalarType, unsigned seed)
+{
+    auto image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(Width, Height, Slices);
+    image->AllocateScalars(scalarType, 1);
+
+    // CT-like range; unsigned types get it shifted up, float a fraction
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> values(-1024, 3071);
+    T* pixels = static_cast<T*>(image->GetScalarPointer());
+    for (vtkIdType i = 0; i < image->GetNumberOfPoints(); ++i) {
+        const int value = values(random);
+        if constexpr (std::is_floating_point<T>::value) {
+            pixels[i] = static_cast<T>(value + 0.25);
+        } else if constexpr (std::is_unsigned<T>::value) {
+            pixels[i] = static_cast<T>(value + 1024);
+        } else {
+            pixels[i] = static_cast<T>(value);
+        }
+    }
+    return image;
+}
+
+using PixelSet = std::set<std::pair<int, int>>; // (y, x)
+
+// Every pixel of the spans, failing on duplicates or out-of-image pixels
+bool collect(const QVector<RowSpan>& spans, int width, int height, PixelSet& pixels)
+{
+    for (const RowSpan& span : spans) {
+        if (span.y < 0 || span.y >= height || span.x0 < 0 || span.x1 >= width || span.x0 > span.x1) {
+            return false;
+        }
+        for (int x = span.x0; x <= span.x1; ++x) {
+            if (!pixels.insert({span.y, x}).second) return false;
+        }
+    }
+    return true;
+}
+
+PixelSet ellipsePixels(const QRectF& bounds, int width, int height)
+{
+    PixelSet pixels;
+    const QPointF centre = bounds.center();
+    const double rx = bounds.width() / 2.0;
+    const double ry = bounds.height() / 2.0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const double dx = (x - centre.x()) / rx;
+            const double dy = (y - centre.y()) / ry;
+            if (dx * dx + dy * dy <= 1.0) pixels.insert({y, x});
+        }
+    }
+    return pixels;
+}
+
+// Even-odd rule at the pixel centre
+PixelSet polygonPixels(const QPolygonF& polygon, int width, int height)
+{
+    PixelSet pixels;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            bool inside = false;
+            for (int i = 0; i < polygon.size(); ++i) {
+                const QPointF& a = polygon[i];
+                const QPointF& b = polygon[(i + 1) % polygon.size()];
+                if ((a.y() <= y) != (b.y() <= y) &&
+                    x >= a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y())) {
+                    inside = !inside;
+                }
+            }
+            if (inside) pixels.insert({y, x});
+        }
+    }
+    return pixels;
+}
+
+template<typename T>
+RoiStats bruteForce(vtkImageData* image, int slice, const PixelSet& pixels, double slope, double intercept)
+{
+    const T* values = static_cast<const T*>(image->GetScalarPointer(0, 0, slice));
+    double sum = 0.0;
+    double minValue = std::numeric_limits<double>::max();
+    double maxValue = std::numeric_limits<double>::lowest();
+    for (const auto& pixel : pixels) {
+        const double value = values[pixel.first * Width + pixel.second] * slope + intercept;
+        sum += value;
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+
+    RoiStats stats;
+    stats.pixelCount = static_cast<qint64>(pixels.size());
+    if (stats.pixelCount == 0) return stats;
+    stats.mean = sum / stats.pixelCount;
+    double squares = 0.0;
+    for (const auto& pixel : pixels) {
+        const double delta = values[pixel.first * Width + pixel.second] * slope + intercept - stats.mean;
+        squares += delta * delta;
+    }
+    stats.stdDev = stats.pixelCount > 1 ? std::sqrt(squares / (stats.pixelCount - 1)) : 0.0;
+    stats.minValue = minValue;
+    stats.maxValue = maxValue;
+    return stats;
+}
+
+bool close(double a, double b)
+{
+    return std::abs(a - b) <= 1e-9 * std::max(1.0, std::max(std::abs(a), std::abs(b)));
+}
+
+bool sameStats(const RoiStats& a, const RoiStats& b)
+{
+    return a.pixelCount == b.pixelCount && close(a.mean, b.mean) && close(a.stdDev, b.stdDev)
+        && a.minValue == b.minValue && a.maxValue == b.maxValue;
+}
+
+} // namespace
+
+class RoiStatisticsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rectangleMatchesBruteForce();
+    void ellipseMatchesBruteForce();
+    void polygonMatchesBruteForce();
+    void floatImageMatchesBruteForce();
+    void minMaxAcrossBlockEdges();
+    void degenerateEllipseIsEmpty();
+    void selfIntersectingPolygonCountsPixelsOnce();
+    void spansAreClippedAtImageBorders();
+};
+
+void RoiStatisticsTest::rectangleMatchesBruteForce()
+{
+    auto image = randomImage<qint16>(VTK_SHORT, 1);
+    RoiStatistics roi(image, 2.0, -1024.0, 0.5, 0.5, nullptr);
+
+    // Inside, swapped corners, hanging over every border and a single pixel
+    const int rects[][4] = {{3, 4, 40, 30}, {60, 40, 31, 1}, {-5, -7, Width + 3, Height + 9}, {69, 44, 69, 44}};
+    for (int slice = 0; slice < Slices; ++slice) {
+        for (const auto& rect : rects) {
+            PixelSet pixels;
+            for (int y = std::max(0, std::min(rect[1], rect[3])); y <= std::min(Height - 1, std::max(rect[1], rect[3])); ++y) {
+                for (int x = std::max(0, std::min(rect[0], rect[2])); x <= std::min(Width - 1, std::max(rect[0], rect[2])); ++x) {
+                    pixels.insert({y, x});
+                }
+            }
+            const RoiStats stats = roi.rectangle(slice, rect[0], rect[1], rect[2], rect[3]);
+            QVERIFY(sameStats(stats, bruteForce<qint16>(image, slice, pixels, 2.0, -1024.0)));
+            QCOMPARE(stats.areaMm2, stats.pixelCount * 0.25);
+        }
+    }
+
+    // Entirely outside the image
+    QVERIFY(!roi.rectangle(0, Width + 1, 0, Width + 5, 5).isValid());
+}
+
+void RoiStatisticsTest::ellipseMatchesBruteForce()
+{
+    auto image = randomImage<qint16>(VTK_SHORT, 2);
+    RoiStatistics roi(image, 1.0, 0.0, 1.0, 1.0, nullptr);
+
+    const QRectF bounds[] = {QRectF(10.3, 5.6, 40.2, 30.9), QRectF(50.7, 40.1, -20.4, -12.2),
+                             QRectF(33.1, 2.4, 1.8, 38.3)};
+    for (const QRectF& rect : bounds) {
+        PixelSet pixels;
+        QVERIFY(collect(ellipseSpans(rect, Width, Height), Width, Height, pixels));
+        QVERIFY(pixels == ellipsePixels(rect.normalized(), Width, Height));
+        QVERIFY(sameStats(roi.ellipse(1, rect), bruteForce<qint16>(image, 1, pixels, 1.0, 0.0)));
+    }
+}
+
+void RoiStatisticsTest::polygonMatchesBruteForce()
+{
+    auto image = randomImage<quint16>(VTK_UNSIGNED_SHORT, 3);
+    RoiStatistics roi(image, 1.0, -1024.0, 1.0, 1.0, nullptr);
+
+    QPolygonF concave;
+    concave << QPointF(5.2, 3.7) << QPointF(60.4, 8.1) << QPointF(30.6, 20.3)
+            << QPointF(62.9, 40.2) << QPointF(8.3, 38.8);
+
+    PixelSet pixels;
+    QVERIFY(collect(polygonSpans(concave, Width, Height), Width, Height, pixels));
+    QVERIFY(pixels == polygonPixels(concave, Width, Height));
+    QVERIFY(sameStats(roi.polygon(2, concave), bruteForce<quint16>(image, 2, pixels, 1.0, -1024.0)));
+
+    // Fewer than three points is not an area
+    QPolygonF line;
+    line << QPointF(1.0, 1.0) << QPointF(20.0, 20.0);
+    QVERIFY(polygonSpans(line, Width, Height).isEmpty());
+}
+
+void RoiStatisticsTest::floatImageMatchesBruteForce()
+{
+    auto image = randomImage<float>(VTK_FLOAT, 4);
+    RoiStatistics roi(image, 1.0, 0.0, 1.0, 1.0, nullptr);
+
+    const QRectF bounds(4.4, 3.3, 55.5, 33.3);
+    PixelSet pixels;
+    QVERIFY(collect(ellipseSpans(bounds, Width, Height), Width, Height, pixels));
+    const RoiStats stats = roi.ellipse(0, bounds);
+    const RoiStats expected = bruteForce<float>(image, 0, pixels, 1.0, 0.0);
+    QCOMPARE(stats.pixelCount, expected.pixelCount);
+    QVERIFY(std::abs(stats.mean - expected.mean) < 1e-6 * std::abs(expected.mean) + 1e-6);
+    QVERIFY(std::abs(stats.stdDev - expected.stdDev) < 1e-6 * expected.stdDev);
+    QCOMPARE(stats.minValue, expected.minValue);
+    QCOMPARE(stats.maxValue, expected.maxValue);
+}
+
+void RoiStatisticsTest::minMaxAcrossBlockEdges()
+{
+    auto image = randomImage<qint16>(VTK_SHORT, 5);
+    RoiStatistics roi(image, 1.0, 0.0, 1.0, 1.0, nullptr);
+
+    // Inside one block, ending and starting on block edges, whole blocks
+    // plus ragged ends, and the short last block of the row
+    const int ranges[][2] = {{3, 9}, {0, 31}, {32, 63}, {31, 32}, {5, 68}, {64, 69}, {0, 69}, {33, 33}};
+    for (int y = 0; y < Height; y += 7) {
+        for (const auto& range : ranges) {
+            const QVector<RowSpan> spans{{y, range[0], range[1]}};
+            PixelSet pixels;
+            QVERIFY(collect(spans, Width, Height, pixels));
+            QVERIFY(sameStats(roi.spans(1, spans), bruteForce<qint16>(image, 1, pixels, 1.0, 0.0)));
+        }
+    }
+}
+
+void RoiStatisticsTest::degenerateEllipseIsEmpty()
+{
+    auto image = randomImage<qint16>(VTK_SHORT, 6);
+    RoiStatistics roi(image, 1.0, 0.0, 1.0, 1.0, nullptr);
+
+    QVERIFY(ellipseSpans(QRectF(10.0, 10.0, 0.0, 20.0), Width, Height).isEmpty());
+    QVERIFY(ellipseSpans(QRectF(10.0, 10.0, 20.0, 0.0), Width, Height).isEmpty());
+    QVERIFY(ellipseSpans(QRectF(10.0, 10.0, 0.0, 0.0), Width, Height).isEmpty());
+    QVERIFY(!roi.ellipse(0, QRectF(10.0, 10.0, 0.0, 20.0)).isValid());
+
+    // Thinner than a pixel and between pixel centres: no pixel inside
+    QVERIFY(ellipseSpans(QRectF(10.2, 10.0, 0.5, 20.0), Width, Height).isEmpty());
+}
+
+void RoiStatisticsTest::selfIntersectingPolygonCountsPixelsOnce()
+{
+    auto image = randomImage<qint16>(VTK_SHORT, 7);
+    RoiStatistics roi(image, 1.0, 0.0, 1.0, 1.0, nullptr);
+
+    // Bow tie whose edges cross between pixel centres
+    QPolygonF bowTie;
+    bowTie << QPointF(0.3, 0.6) << QPointF(9.9, 9.4) << QPointF(9.9, 0.6) << QPointF(0.3, 9.4);
+    PixelSet pixels;
+    QVERIFY(collect(polygonSpans(bowTie, Width, Height), Width, Height, pixels));
+    QVERIFY(pixels == polygonPixels(bowTie, Width, Height));
+    QVERIFY(sameStats(roi.polygon(0, bowTie), bruteForce<qint16>(image, 0, pixels, 1.0, 0.0)));
+
+    // Edges crossing exactly on the pixel centre (5, 5): still one pixel
+    QPolygonF centred;
+    centred << QPointF(0.0, 0.0) << QPointF(10.0, 10.0) << QPointF(10.0, 0.0) << QPointF(0.0, 10.0);
+    PixelSet centredPixels;
+    QVERIFY(collect(polygonSpans(centred, Width, Height), Width, Height, centredPixels));
+    QVERIFY(centredPixels.count({5, 5}) == 1);
+    QCOMPARE(roi.polygon(0, centred).pixelCount, static_cast<qint64>(centredPixels.size()));
+}
+
+void RoiStatisticsTest::spansAreClippedAtImageBorders()
+{
+    auto image = randomImage<qint16>(VTK_SHORT, 8);
+    RoiStatistics roi(image, 1.0, 0.0, 1.0, 1.0, nullptr);
+
+    // Centred on corners and hanging past every edge
+    const QRectF ellipses[] = {QRectF(-10.3, -8.6, 20.2, 17.9), QRectF(Width - 12.7, Height - 9.4, 25.1, 18.3),
+                               QRectF(-30.2, -20.9, Width + 60.1, Height + 40.3)};
+    for (const QRectF& rect : ellipses) {
+        PixelSet pixels;
+        QVERIFY(collect(ellipseSpans(rect, Width, Height), Width, Height, pixels));
+        QVERIFY(pixels == ellipsePixels(rect, Width, Height));
+        QVERIFY(sameStats(roi.ellipse(2, rect), bruteForce<qint16>(image, 2, pixels, 1.0, 0.0)));
+    }
+
+    QPolygonF outside;
+    outside << QPointF(-15.5, 20.2) << QPointF(35.3, -12.8) << QPointF(Width + 9.1, 22.7)
+            << QPointF(34.6, Height + 14.4);
+    PixelSet pixels;
+    QVERIFY(collect(polygonSpans(outside, Width, Height), Width, Height, pixels));
+    QVERIFY(pixels == polygonPixels(outside, Width, Height));
+    QVERIFY(sameStats(roi.polygon(2, outside), bruteForce<qint16>(image, 2, pixels, 1.0, 0.0)));
+
+    // Wholly outside
+    QVERIFY(ellipseSpans(QRectF(Width + 2.0, 2.0, 10.0, 10.0), Width, Height).isEmpty());
+    QVERIFY(!roi.ellipse(2, QRectF(-20.0, -20.0, 10.0, 10.0)).isValid());
+}
+
+QTEST_APPLESS_MAIN(RoiStatisticsTest)
+
+#include "tst_roistatistics.moc"